@@ -0,0 +1,44 @@
+// Benchmark.h
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <algorithm>
+#include <limits>
+
+// Общие средства бенчмарков (цель MusicCatalogBenchmarks,
+// опция MUSICCATALOG_BENCHMARKS)
+namespace Benchmark {
+    // Число повторов каждого замера: берется лучшее время, оно меньше всего
+    // искажено прерываниями и холодными кэшами
+    constexpr int ROUNDS = 5;
+
+    // Лучшее из ROUNDS время выполнения body в наносекундах
+    template<typename Body>
+    qint64 bestOf(const Body& body) {
+        qint64 best = std::numeric_limits<qint64>::max();
+        QElapsedTimer timer;
+        for (int round = 0; round < ROUNDS; ++round) {
+            timer.start();
+            body();
+            best = std::min(best, timer.nsecsElapsed());
+        }
+        return best;
+    }
+
+    // Строка таблицы: название замера, наносекунды на строку и число совпадений
+    inline void report(QTextStream& out, const QString& name, qint64 nanoseconds, qsizetype rows, qsizetype matches) {
+        const double perRow = rows > 0 ? double(nanoseconds) / double(rows) : 0.0;
+        out << name.leftJustified(48) << QString("%1 ns/row").arg(perRow, 9, 'f', 2)
+            << QString("  %1 matches").arg(matches) << "\n";
+        out.flush();
+    }
+}
+
+// Наборы замеров; каждый печатает свою таблицу в out
+void runSubstringBenchmarks(QTextStream& out);
+void runFilterBenchmarks(QTextStream& out);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,107 @@
+// FilterBenchmark.cpp
+#include "Benchmark.h"
+#include "core/FilterPlanner.h"
+#include "core/TrackColumns.h"
+#include "core/TrackRepository.h"
+
+#include <QList>
+#include <QStringList>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace {
+    constexpr qsizetype TRACK_COUNT = 200000;
+
+    // Каталог с фиксированным зерном: каждое условие ниже пропускает
+    // заметную долю строк, поэтому работы хватает всем шагам цепочки
+    void fillRepository(TrackRepository& repository) {
+        const QStringList genres{"Rock", "Pop", "Jazz", "Folk", "Soul", "Blues", "Metal", "Disco",
+                                 "Techno", "House", "Funk", "Punk", "Country", "Gospel", "Opera", "Trance"};
+        const QStringList words{"love", "night", "road", "fire", "rain", "dream", "heart", "light",
+                                "river", "stone", "ghost", "sun", "moon", "city", "time", "home"};
+
+        std::mt19937 random(20);
+        std::uniform_int_distribution<int> artist(0, 199);
+        std::uniform_int_distribution<int> album(0, 999);
+        std::uniform_int_distribution<int> year(1950, 2024);
+        std::uniform_int_distribution<int> duration(60, 600);
+        std::uniform_int_distribution<qsizetype> genre(0, genres.size() - 1);
+        std::uniform_int_distribution<qsizetype> word(0, words.size() - 1);
+        std::uniform_int_distribution<int> percent(0, 99);
+        for (qsizetype index = 0; index < TRACK_COUNT; ++index) {
+            const QString title = QString("%1 %2 %3").arg(words[word(random)], words[word(random)],
+                                                          words[word(random)]);
+            const QString filePath = percent(random) < 30
+                ? QString("https://music.yandex.ru/track/%1").arg(index)
+                : QString("/music/%1.mp3").arg(index);
+            repository.addTrack(title, QString("Artist %1").arg(artist(random)),
+                                QString("Album %1").arg(album(random)), year(random),
+                                genres[genre(random)], duration(random), filePath);
+        }
+    }
+
+    // Запрос с первыми count условиями из семи: год, длительность,
+    // источник, исполнитель, альбом, жанр, название. maxDuration = 3600 —
+    // длительность не ограничена (как в форме поиска).
+    TrackSearchParams paramsWith(int count) {
+        TrackSearchParams params;
+        params.maxDuration = 3600;
+        if (count > 0) {
+            params.minYear = 1960;
+            params.maxYear = 2015;
+        }
+        if (count > 1) {
+            params.minDuration = 120;
+            params.maxDuration = 540;
+        }
+        if (count > 2) {
+            params.source = TrackSource::Local;
+        }
+        if (count > 3) {
+            params.artist = "1";
+        }
+        if (count > 4) {
+            params.album = "5";
+        }
+        if (count > 5) {
+            params.genre = "o";
+        }
+        if (count > 6) {
+            params.title = "e";
+        }
+        return params;
+    }
+}
+
+void runFilterBenchmarks(QTextStream& out) {
+    TrackRepository repository;
+    fillRepository(repository);
+    FilterPlanner planner(repository);
+
+    // Все позиции как кандидаты refine: условия проверяются проходом по
+    // колонкам, без выбора пути доступа по индексам, и сравниваются только
+    // шаги фильтрации. Пул потоков не используется.
+    QList<qsizetype> allSlots(repository.trackColumns().size());
+    std::iota(allSlots.begin(), allSlots.end(), qsizetype(0));
+    const qsizetype sequential = std::numeric_limits<qsizetype>::max();
+    const TrackSearchParams unfiltered = paramsWith(0);
+
+    out << "\nFilterPlanner, " << TRACK_COUNT << " tracks: fused step vs per-predicate narrowing\n";
+    for (int count = 1; count <= 7; ++count) {
+        const TrackSearchParams params = paramsWith(count);
+        qsizetype matches[2] = {0, 0};
+        for (int fused = 1; fused >= 0; --fused) {
+            planner.setFusedSteps(fused != 0);
+            const qint64 elapsed = Benchmark::bestOf([&]() {
+                matches[fused] = planner.refine(params, unfiltered, allSlots, sequential).size();
+            });
+            Benchmark::report(out, QString("%1 predicate(s), %2").arg(count).arg(fused ? "fused" : "per-predicate"),
+                              elapsed, allSlots.size(), matches[fused]);
+        }
+        if (matches[0] != matches[1]) {
+            out << "  result sizes differ\n";
+        }
+    }
+    planner.setFusedSteps(true);
+}
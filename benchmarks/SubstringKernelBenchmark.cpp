@@ -0,0 +1,123 @@
+// SubstringKernelBenchmark.cpp
+#include "Benchmark.h"
+#include "core/SubstringKernel.h"
+#include "core/TextFolding.h"
+
+#include <QList>
+#include <QStringList>
+#include <random>
+
+namespace {
+    constexpr qsizetype TITLE_COUNT = 200000;
+
+    // Набор данных: исходные названия (для QString::contains) и их свернутые
+    // формы (для ядра, которое ищет по свернутому тексту, как TrackColumns)
+    struct Corpus {
+        QString name;
+        QList<QString> titles;
+        QList<QString> folded;
+    };
+
+    // Названия из 2..5 слов, каждое слово — 2..4 слога; генератор с
+    // фиксированным зерном, чтобы замеры были воспроизводимы
+    Corpus makeCorpus(const QString& name, const QStringList& syllables, unsigned seed) {
+        Corpus corpus;
+        corpus.name = name;
+        corpus.titles.reserve(TITLE_COUNT);
+        corpus.folded.reserve(TITLE_COUNT);
+
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> wordCount(2, 5);
+        std::uniform_int_distribution<int> syllableCount(2, 4);
+        std::uniform_int_distribution<qsizetype> syllable(0, syllables.size() - 1);
+        for (qsizetype index = 0; index < TITLE_COUNT; ++index) {
+            QStringList words;
+            const int count = wordCount(random);
+            for (int word = 0; word < count; ++word) {
+                QString text;
+                const int length = syllableCount(random);
+                for (int part = 0; part < length; ++part) {
+                    text += syllables[syllable(random)];
+                }
+                // Первое слово с заглавной буквы, чтобы свертка регистра
+                // не была пустой работой
+                if (word == 0) {
+                    text[0] = text[0].toUpper();
+                }
+                words.append(text);
+            }
+            const QString title = words.join(' ');
+            corpus.titles.append(title);
+            corpus.folded.append(TextFolding::fold(title));
+        }
+        return corpus;
+    }
+
+    const char* implementationName(SubstringKernel::Implementation implementation) {
+        switch (implementation) {
+        case SubstringKernel::Implementation::Avx2:
+            return "avx2";
+        case SubstringKernel::Implementation::Sse2:
+            return "sse2";
+        case SubstringKernel::Implementation::Scalar:
+            break;
+        }
+        return "scalar";
+    }
+
+    void runCorpus(QTextStream& out, const Corpus& corpus, const QStringList& patterns) {
+        const SubstringKernel::Implementation implementations[] = {
+            SubstringKernel::Implementation::Avx2,
+            SubstringKernel::Implementation::Sse2,
+            SubstringKernel::Implementation::Scalar,
+        };
+        const qsizetype rows = corpus.titles.size();
+
+        for (const QString& pattern : patterns) {
+            out << "\n" << corpus.name << ", \"" << pattern << "\"\n";
+            const QString foldedPattern = TextFolding::fold(pattern);
+
+            for (SubstringKernel::Implementation implementation : implementations) {
+                if (!SubstringKernel::isAvailable(implementation)) {
+                    continue;
+                }
+                qsizetype matches = 0;
+                const qint64 elapsed = Benchmark::bestOf([&]() {
+                    matches = 0;
+                    for (const QString& title : corpus.folded) {
+                        matches += SubstringKernel::contains(title, foldedPattern, implementation);
+                    }
+                });
+                Benchmark::report(out, QString("SubstringKernel (%1)").arg(implementationName(implementation)),
+                                  elapsed, rows, matches);
+            }
+
+            // Прежний путь: регистронезависимый поиск по исходной строке
+            qsizetype matches = 0;
+            const qint64 elapsed = Benchmark::bestOf([&]() {
+                matches = 0;
+                for (const QString& title : corpus.titles) {
+                    matches += title.contains(pattern, Qt::CaseInsensitive);
+                }
+            });
+            Benchmark::report(out, "QString::contains (CaseInsensitive)", elapsed, rows, matches);
+        }
+    }
+}
+
+void runSubstringBenchmarks(QTextStream& out) {
+    out << "SubstringKernel::contains, " << TITLE_COUNT << " titles, active kernel: "
+        << SubstringKernel::implementationName() << "\n";
+
+    // Образцы: короткий и длинный с совпадениями, короткий и длинный без них.
+    // Латинские слоги не содержат "q" и "x", кириллические — "щ" и "ъ".
+    const Corpus latin = makeCorpus("Latin",
+                                    {"la", "mo", "ri", "ta", "ne", "so", "ku", "vel", "dan", "ber", "lin", "gor"},
+                                    9);
+    runCorpus(out, latin, {"Ta", "Moridan", "xq", "Velberqux"});
+
+    const Corpus cyrillic = makeCorpus("Cyrillic",
+                                       {"ла", "мо", "ри", "та", "не", "со", "ку", "вел", "дан", "бер", "лин", "гор"},
+                                       9);
+    runCorpus(out, cyrillic, {"Та", "Моридан", "щъ", "Велберщук"});
+}
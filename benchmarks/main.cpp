@@ -0,0 +1,25 @@
+// main.cpp — бенчмарки поиска. Аргументы — имена наборов ("substring", "filters");
+// без аргументов выполняются все наборы.
+#include "Benchmark.h"
+
+#include <QStringList>
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+    QStringList suites;
+    for (int index = 1; index < argc; ++index) {
+        suites.append(QString::fromLocal8Bit(argv[index]));
+    }
+    auto selected = [&suites](const QString& name) {
+        return suites.isEmpty() || suites.contains(name);
+    };
+
+    QTextStream out(stdout);
+    if (selected("substring")) {
+        runSubstringBenchmarks(out);
+    }
+    if (selected("filters")) {
+        runFilterBenchmarks(out);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+// FilterPlanner.h
+#ifndef FILTERPLANNER_H
+#define FILTERPLANNER_H
+
+#include "core/SearchPlan.h"
+#include "core/TrackSearchParams.h"
+#include <QList>
+
+class TrackRepository;
+
+// Стоимостной планировщик поиска с фильтрами.
+// По статистике колонок оценивает селективность каждого условия, выбирает
+// путь доступа (пересечение битовых индексов года, длительности, жанра и
+// источника, триграммный индекс названий или полный проход) и проверяет
+// оставшиеся условия по возрастанию ранга
+// cost / (1 - selectivity). Выполнение идет по колонкам: каждый шаг сужает
+// список позиций, полученный от предыдущего. Соседние в этом порядке дешевые
+// условия (все, кроме названия) проверяются одним шагом в том же порядке
+// ранга: ядром-шаблоном, специализированным по набору активных условий, если
+// ранг совпадает с его порядком, иначе проверкой с порядком из плана.
+// Поиска по id в TrackSearchParams нет, поэтому индекс id как путь доступа
+// не рассматривается.
+class FilterPlanner {
+public:
+    explicit FilterPlanner(const TrackRepository& repository);
+
+    // Позиции подходящих треков в порядке каталога. Списки длиннее
+    // parallelThreshold фильтруются в пуле потоков. Если plan не nullptr,
+    // в него записываются выбранный план и фактическое время шагов.
+    QList<qsizetype> execute(const TrackSearchParams& params, qsizetype parallelThreshold,
+                             SearchPlan* plan = nullptr) const;
+    // Уточнить прошлый результат: проверяются только позиции candidates и
+    // только условия, изменившиеся по сравнению с previous. Применимо,
+    // если narrows(params, previous).
+    QList<qsizetype> refine(const TrackSearchParams& params, const TrackSearchParams& previous,
+                            const QList<qsizetype>& candidates, qsizetype parallelThreshold) const;
+
+    // Каждый трек, подходящий под narrower, подходит и под wider
+    static bool narrows(const TrackSearchParams& narrower, const TrackSearchParams& wider);
+    // Нормализованный ключ запроса: равные ключи дают одинаковый результат
+    static QString canonicalKey(const TrackSearchParams& params);
+
+    // Объединять соседние дешевые условия в один шаг (по умолчанию).
+    // false — каждое условие отдельным шагом, для сравнения в бенчмарках.
+    void setFusedSteps(bool fused) { fusedSteps = fused; }
+
+private:
+    const TrackRepository& repository;
+    bool fusedSteps = true;
+};
+
+#endif // FILTERPLANNER_H
@@ -0,0 +1,61 @@
+// FuzzyIndex.h
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+// Индекс для поиска с опечатками: BK-дерево по различным словам свернутых
+// строк (TextFolding::fold) и список ключей документов для каждого слова.
+// Дерево опирается на неравенство треугольника для расстояния Левенштейна:
+// при расстоянии d до узла потомки дальше d ± k не проверяются.
+// Слова удаленных документов остаются в дереве без ключей; когда таких узлов
+// становится больше четверти, дерево перестраивается из живых слов.
+class FuzzyIndex {
+public:
+    static constexpr int MAX_DISTANCE = 2;
+
+    struct Match {
+        int key;
+        int distance; // сумма расстояний по словам запроса
+    };
+
+    FuzzyIndex() = default;
+
+    void insert(int key, const QString& foldedText);
+    void remove(int key, const QString& foldedText);
+    void clear();
+
+    // Документы, в которых для каждого слова запроса есть слово на расстоянии
+    // не больше допустимого: короткие слова (до 3 символов) сравниваются точно,
+    // слова до 6 символов допускают одну правку, длинные — maxDistance.
+    // Результат упорядочен по расстоянию, затем по ключу.
+    QList<Match> search(const QString& foldedQuery, int maxDistance) const;
+
+    // Слова строки: последовательности букв и цифр, без повторов
+    static QStringList tokensOf(const QString& foldedText);
+    // Расстояние Левенштейна по кодовым единицам UTF-16
+    static int distance(const QString& a, const QString& b);
+
+private:
+    struct Node {
+        QString token;
+        QList<int> keys; // по возрастанию
+        QList<QPair<int, qsizetype>> children; // расстояние -> узел
+    };
+
+    qsizetype nodeFor(const QString& token);
+    // Собрать дерево заново только из слов, у которых остались ключи
+    void rebuild();
+    // Лучшее расстояние для каждого ключа среди слов не дальше limit
+    QHash<int, int> nearestKeys(const QString& token, int limit) const;
+
+    QList<Node> nodes; // nodes[0] — корень
+    QHash<QString, qsizetype> nodeIndex;
+    qsizetype emptyNodes = 0; // узлы без ключей
+};
+
+#endif // FUZZYINDEX_H
@@ -4,10 +4,14 @@
 
 #include "core/Track.h"
 #include "core/TrackRepository.h"
+#include "core/TrackView.h"
 #include "core/TrackSearcher.h"
 #include "core/TrackSorter.h"
 #include "core/TrackSearchParams.h"
+#include "core/SearchPlan.h"
+#include "core/QueryCache.h"
 #include <QList>
+#include <QMap>
 #include <QString>
 
 class MusicCatalog {
@@ -24,9 +28,9 @@ public:
     bool updateTrack(int id, const Track& updatedTrack);
 
     // Поиск
-    Track* findTrackById(int id);
     const Track* findTrackById(int id) const;
     QList<Track> findAllTracks() const;
+    TrackView tracksView() const;
     QList<Track> findTracksByTitle(const QString& title) const;
     QList<Track> findTracksByArtist(const QString& artist) const;
     QList<Track> findTracksByAlbum(const QString& album) const;
@@ -34,22 +38,65 @@ public:
     QList<Track> findTracksByYearRange(int startYear, int endYear) const;
     QList<Track> searchTracks(const QString& searchTerm) const;
     QList<Track> searchTracksWithFilters(const TrackSearchParams& params) const;
+    // Поиск по запросу языка поиска (см. TrackQuery), ошибки — ParseException
+    QList<Track> searchTracksByQuery(const QString& query) const;
+    QList<int> searchTrackIdsByQuery(const QString& query, const ResultWindow& window = ResultWindow()) const;
+    // Поиск по словам с ранжированием по релевантности (BM25), лучшие первыми
+    QList<Track> searchTracksRanked(const QString& query, qsizetype limit = -1) const;
+    // Поиск с опечатками в названии и исполнителе, ближайшие совпадения первыми
+    QList<Track> fuzzySearchTracks(const QString& query, int maxDistance = FuzzyIndex::MAX_DISTANCE) const;
+    // Id найденных треков в заданном порядке и окне, без копирования треков
+    QList<int> searchTrackIds(const QString& searchTerm, const ResultWindow& window = ResultWindow()) const;
+    QList<int> searchTrackIdsWithFilters(const TrackSearchParams& params,
+                                         const ResultWindow& window = ResultWindow()) const;
+    void setParallelSearchThreshold(qsizetype threshold);
+    // План поиска с фильтрами и время его шагов, для диагностики медленных запросов
+    SearchPlan explainSearch(const TrackSearchParams& params) const;
+    // Сессия поиска по мере набора (действует, пока жив каталог)
+    SearchSession startSearchSession() const;
+
+    // Кэш результатов поиска по строке и по фильтрам
+    void setQueryCacheBudget(qsizetype budgetBytes);
+    QueryCache::Stats queryCacheStats() const;
+
+    // Окно каталога в заданном порядке без сортировки хранилища, например
+    // строки 5000-5100 по исполнителю; порядок поддерживается при изменениях
+    QList<int> trackIdsInOrder(const ResultWindow& window) const;
+    // Первые count треков в порядке spec без сортировки хранилища, например
+    // 10 самых длинных: topTrackIds({{TrackOrder::Duration, false}}, 10).
+    // С фильтром частичная выборка идет по позициям, отобранным планировщиком.
+    QList<int> topTrackIds(const QList<SortKey>& spec, qsizetype count) const;
+    QList<int> topTrackIds(const TrackSearchParams& params, const QList<SortKey>& spec, qsizetype count) const;
 
     // Сортировка
     void sortByTitle(bool ascending = true);
     void sortByArtist(bool ascending = true);
     void sortByYear(bool ascending = true);
     void sortByDuration(bool ascending = true);
+    // Ключи применяются по порядку: следующий решает при равенстве предыдущих
+    void sortBy(const QList<SortKey>& spec);
+    void setParallelSortThreshold(qsizetype threshold);
 
     // Статистика
     int getTrackCount() const;
+    // Число треков по значениям колонок, берется из битовых индексов
+    QMap<QString, qsizetype> countTracksByGenre() const;
+    QMap<int, qsizetype> countTracksByYear() const;
+    qsizetype countTracksBySource(TrackSource source) const;
     int getNextId() const;
     void updateNextId();
+    // Версия каталога: меняется при каждом изменении треков или их порядка
+    quint64 getGeneration() const;
 
 private:
+    QList<Track> tracksWithIds(const QList<int>& ids) const;
+    template<typename Search>
+    QList<int> cachedSearch(const QString& key, const ResultWindow& window, Search search) const;
+
     TrackRepository repository;
     TrackSearcher searcher;
     TrackSorter sorter;
+    mutable QueryCache queryCache;
 };
 
 #endif // MUSICCATALOG_H
@@ -0,0 +1,41 @@
+// ParallelFor.h
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <QSemaphore>
+#include <QThreadPool>
+#include <algorithm>
+
+// Разбиение работы на фрагменты и их выполнение в глобальном пуле потоков
+class ParallelFor {
+public:
+    // Минимальный размер фрагмента по умолчанию: более мелкие не окупают
+    // постановку задачи в пул
+    static constexpr qsizetype MIN_CHUNK_SIZE = 4096;
+
+    // Число фрагментов для count элементов: не больше потоков пула и не
+    // мельче minChunkSize элементов; 1 — выполнять последовательно
+    static qsizetype chunkCount(qsizetype count, qsizetype minChunkSize = MIN_CHUNK_SIZE) {
+        return std::clamp<qsizetype>(count / minChunkSize, 1, QThreadPool::globalInstance()->maxThreadCount());
+    }
+
+    // Выполнить task(0..taskCount) в пуле; задачу 0 выполняет вызывающий
+    // поток. Возврат после завершения всех задач.
+    template<typename Task>
+    static void run(qsizetype taskCount, const Task& task) {
+        QThreadPool* pool = QThreadPool::globalInstance();
+        QSemaphore finished;
+        for (qsizetype index = 1; index < taskCount; ++index) {
+            pool->start([&task, &finished, index]() {
+                task(index);
+                finished.release();
+            });
+        }
+        if (taskCount > 0) {
+            task(0);
+        }
+        finished.acquire(static_cast<int>(std::max<qsizetype>(taskCount - 1, 0)));
+    }
+};
+
+#endif // PARALLELFOR_H
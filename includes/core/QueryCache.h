@@ -0,0 +1,45 @@
+// QueryCache.h
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <QCache>
+#include <QList>
+#include <QString>
+
+// LRU-кэш результатов поиска: нормализованный запрос -> список id треков.
+// Каждый результат верен только для своего поколения данных репозитория;
+// при смене поколения кэш очищается целиком. Объем ограничен бюджетом
+// в байтах, старые записи вытесняются первыми.
+class QueryCache {
+public:
+    static constexpr qsizetype DEFAULT_BUDGET = 8 * 1024 * 1024;
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qsizetype entries = 0;
+        qsizetype bytes = 0;
+        qsizetype budget = 0;
+    };
+
+    explicit QueryCache(qsizetype budgetBytes = DEFAULT_BUDGET);
+
+    // Результат для ключа, если он посчитан в том же поколении данных
+    bool lookup(const QString& key, quint64 currentGeneration, QList<int>& ids);
+    void insert(const QString& key, quint64 currentGeneration, const QList<int>& ids);
+
+    void setBudget(qsizetype budgetBytes);
+    void clear();
+    Stats stats() const;
+
+private:
+    // Смена поколения делает все сохраненные результаты устаревшими
+    void syncGeneration(quint64 current);
+
+    QCache<QString, QList<int>> entries;
+    quint64 generation = 0;
+    qint64 hits = 0;
+    qint64 misses = 0;
+};
+
+#endif // QUERYCACHE_H
@@ -0,0 +1,34 @@
+// RangeIndex.h
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include "core/RoaringBitmap.h"
+#include <QList>
+#include <QMap>
+
+// Упорядоченный вторичный индекс по целочисленному ключу (год, длительность).
+// Ключи образуют небольшой домен, поэтому индекс хранится корзинами:
+// значение ключа -> битовая карта id треков. Запрос диапазона стоит
+// O(log n + k), число строк в диапазоне считается без обхода id.
+class RangeIndex {
+public:
+    RangeIndex() = default;
+
+    void insert(int key, int id);
+    void remove(int key, int id);
+    void clear();
+
+    // Число треков с ключом в [min, max]
+    qsizetype count(int min, int max) const;
+    // Число треков для каждого значения ключа
+    QMap<int, qsizetype> counts() const;
+    // Множество треков с ключом в [min, max]
+    RoaringBitmap bitmap(int min, int max) const;
+    // Id треков с ключом в [min, max] по возрастанию
+    QList<int> ids(int min, int max) const { return bitmap(min, max).toList(); }
+
+private:
+    QMap<int, RoaringBitmap> buckets;
+};
+
+#endif // RANGEINDEX_H
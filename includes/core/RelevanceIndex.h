@@ -0,0 +1,83 @@
+// RelevanceIndex.h
+#ifndef RELEVANCEINDEX_H
+#define RELEVANCEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <array>
+
+// Полнотекстовый индекс для ранжирования по BM25F: частоты слов в полях
+// трека складываются с весами полей, длина поля нормируется по средней.
+// Для каждого слова лениво строится список вкладов (impact) документов по
+// убыванию: top-k выбирается алгоритмом порогов и останавливается, как только
+// непросмотренные документы уже не могут войти в результат.
+// Вклад в списке хранится без idf (idf одинаков для всего списка и порядка
+// не меняет) и умножается на него при поиске. Средние длины полей берутся из
+// снимка, который обновляется, только когда фактические средние отходят от
+// него больше чем на NORMALIZATION_TOLERANCE; списки помнят версию снимка и
+// перестраиваются при использовании, если она устарела. Изменение документа
+// сбрасывает только списки его слов. Поиск строит списки и потому не
+// потокобезопасен.
+class RelevanceIndex {
+public:
+    enum Field { Title, Artist, Album, Genre, FIELD_COUNT };
+
+    // Параметры BM25 и веса полей: название и исполнитель важнее
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+    static constexpr std::array<double, FIELD_COUNT> FIELD_WEIGHTS = {3.0, 2.0, 1.0, 1.0};
+    // Относительное отклонение средней длины поля, после которого снимок
+    // средних обновляется
+    static constexpr double NORMALIZATION_TOLERANCE = 0.01;
+
+    struct Hit {
+        int key;
+        double score;
+    };
+
+    RelevanceIndex() = default;
+
+    // Поля — свернутые строки (TextFolding::fold) в порядке Field
+    void insert(int key, const std::array<QString, FIELD_COUNT>& foldedFields);
+    void remove(int key);
+    void clear();
+
+    // Документы, содержащие хотя бы одно слово запроса, по убыванию оценки
+    // (при равенстве — по возрастанию ключа). limit < 0 — все документы.
+    QList<Hit> search(const QString& foldedQuery, qsizetype limit) const;
+
+private:
+    using FieldCounts = std::array<int, FIELD_COUNT>;
+
+    struct Posting {
+        int key;
+        double impact;
+    };
+
+    // Вклады документов для одного слова (без idf): по убыванию и для
+    // доступа по ключу; version — версия снимка средних длин
+    struct Impacts {
+        QList<Posting> ordered;
+        QHash<int, double> byKey;
+        quint64 version = 0;
+    };
+
+    // Построить вклады слова, если их нет в кэше или они построены по
+    // устаревшему снимку; слова вне индекса не кэшируются
+    void cacheImpacts(const QString& term) const;
+    // Сбросить списки вкладов слов документа
+    void invalidate(const QList<QStringList>& fields);
+    // Обновить снимок средних длин, если фактические средние отошли от него
+    void updateNormalization();
+
+    QHash<QString, QHash<int, FieldCounts>> postings; // слово -> ключ -> частоты
+    QHash<int, QList<QStringList>> documents;          // ключ -> слова полей
+    std::array<qint64, FIELD_COUNT> totalLengths = {};
+    std::array<double, FIELD_COUNT> averageLengths = {};
+    quint64 normalizationVersion = 0;
+    mutable QHash<QString, Impacts> impactCache;
+};
+
+#endif // RELEVANCEINDEX_H
@@ -0,0 +1,55 @@
+// RoaringBitmap.h
+#ifndef ROARINGBITMAP_H
+#define ROARINGBITMAP_H
+
+#include <QList>
+
+// Сжатое множество 32-битных значений (id треков) в духе Roaring bitmap.
+// Значения делятся на блоки по старшим 16 битам. Разреженный блок хранится
+// отсортированным массивом младших 16 бит, плотный (больше ARRAY_LIMIT
+// значений) - битовой картой на 65536 бит. Пересечение и объединение
+// работают поблочно словами по 64 бита.
+class RoaringBitmap {
+public:
+    RoaringBitmap() = default;
+
+    void add(quint32 value);
+    void remove(quint32 value);
+    bool contains(quint32 value) const;
+    void clear() { blocks.clear(); }
+
+    qsizetype cardinality() const;
+    bool isEmpty() const { return blocks.isEmpty(); }
+
+    RoaringBitmap& operator|=(const RoaringBitmap& other);
+    RoaringBitmap& operator&=(const RoaringBitmap& other);
+    friend RoaringBitmap operator|(RoaringBitmap left, const RoaringBitmap& right) { return left |= right; }
+    friend RoaringBitmap operator&(RoaringBitmap left, const RoaringBitmap& right) { return left &= right; }
+
+    // Все значения по возрастанию
+    QList<int> toList() const;
+
+private:
+    // Предел разреженного блока: больше значений выгоднее хранить битовой картой
+    static constexpr qsizetype ARRAY_LIMIT = 4096;
+    static constexpr qsizetype BITMAP_WORDS = 65536 / 64;
+
+    struct Block {
+        quint16 key = 0;          // старшие 16 бит значений
+        qsizetype count = 0;
+        QList<quint16> values;    // разреженный блок: младшие 16 бит по возрастанию
+        QList<quint64> bits;      // плотный блок: BITMAP_WORDS слов
+
+        bool isDense() const { return !bits.isEmpty(); }
+    };
+
+    qsizetype findBlock(quint16 key) const;
+    static void toDense(Block& block);
+    static void toSparseIfSmall(Block& block);
+    static Block unite(const Block& left, const Block& right);
+    static Block intersect(const Block& left, const Block& right);
+
+    QList<Block> blocks; // по возрастанию key
+};
+
+#endif // ROARINGBITMAP_H
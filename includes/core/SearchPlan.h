@@ -0,0 +1,29 @@
+// SearchPlan.h
+#ifndef SEARCHPLAN_H
+#define SEARCHPLAN_H
+
+#include <QList>
+#include <QString>
+
+// Один шаг выполненного плана поиска
+struct SearchPlanStep {
+    QString operation;                 // scan, trigram, filter, materialize
+    QString detail;                    // проверяемое условие
+    double estimatedSelectivity = 1.0; // оценка доли прошедших строк
+    qsizetype inputRows = 0;
+    qsizetype outputRows = 0;
+    qint64 elapsedNs = 0;
+};
+
+// План поиска с фильтрами и фактическое время его шагов (см. MusicCatalog::explainSearch)
+struct SearchPlan {
+    QString accessPath;
+    double estimatedCost = 0.0;
+    qsizetype estimatedRows = 0;
+    QList<SearchPlanStep> steps;
+
+    qint64 totalNs() const;
+    QString toString() const;
+};
+
+#endif // SEARCHPLAN_H
@@ -0,0 +1,39 @@
+// SearchSession.h
+#ifndef SEARCHSESSION_H
+#define SEARCHSESSION_H
+
+#include "core/FilterPlanner.h"
+#include "core/TrackSearchParams.h"
+#include <QList>
+
+class TrackRepository;
+
+// Сессия поиска по мере набора запроса.
+// Помнит результат прошлого запроса. Если новый запрос только сужает
+// прошлый (например, "metal" -> "metall" или более узкий диапазон годов),
+// проверяются лишь прошлые совпадения и лишь изменившиеся условия.
+// Любое изменение репозитория (поколение данных) сбрасывает сессию.
+class SearchSession {
+public:
+    SearchSession(const TrackRepository& repository, qsizetype parallelThreshold);
+
+    // Id подходящих треков в порядке каталога
+    QList<int> search(const TrackSearchParams& params);
+    void reset();
+
+    // Был ли последний запрос выполнен уточнением прошлого результата
+    bool wasRefined() const { return refined; }
+
+private:
+    const TrackRepository& repository;
+    FilterPlanner planner;
+    qsizetype parallelThreshold;
+
+    bool valid = false;
+    bool refined = false;
+    quint64 generation = 0;
+    TrackSearchParams lastParams;
+    QList<qsizetype> lastSlots;
+};
+
+#endif // SEARCHSESSION_H
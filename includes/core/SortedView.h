@@ -0,0 +1,72 @@
+// SortedView.h
+#ifndef SORTEDVIEW_H
+#define SORTEDVIEW_H
+
+#include "core/TrackSearchParams.h"
+#include <QByteArray>
+#include <QList>
+
+// Поддерживаемый порядок треков по одному ключу сортировки: записи с копиями
+// ключей (QByteArray разделяют данные с колонками) лежат в отсортированных
+// фрагментах до 2 * CHUNK_SIZE записей. Размеры фрагментов хранятся в дереве
+// Фенвика, поэтому позиция окна находится за O(log n). Вставка и удаление —
+// двоичный поиск фрагмента и сдвиг внутри него: O(log n) сравнений и
+// O(CHUNK_SIZE) перемещений; разбиение переполненного фрагмента добавляет
+// O(n / CHUNK_SIZE) раз в CHUNK_SIZE вставок. Чтение представление не меняет.
+class SortedView {
+public:
+    struct Entry {
+        int number = 0;         // год или длительность; для строковых ключей 0
+        QByteArray primary;
+        QByteArray secondary;
+        int id = 0;             // равные ключи упорядочиваются по id
+
+        bool operator<(const Entry& other) const;
+        bool operator==(const Entry& other) const;
+        // Сравнение только ключей, без id
+        bool keysBefore(const Entry& other) const;
+    };
+
+    // Размер фрагмента после assign и после разбиения
+    static constexpr qsizetype CHUNK_SIZE = 512;
+
+    SortedView() = default;
+
+    // Заменить содержимое (записи в любом порядке), O(n log n)
+    void assign(QList<Entry> entries);
+    void insert(const Entry& entry);
+    // Убрать запись с теми же ключами и id; false, если ее нет
+    bool remove(const Entry& entry);
+    void clear();
+
+    qsizetype size() const { return total; }
+    // Id записей окна по возрастанию или убыванию ключа (window.orderBy не
+    // учитывается). Равные ключи в обоих направлениях идут по возрастанию id.
+    QList<int> ids(const ResultWindow& window) const;
+
+private:
+    // Позиция записи: номер фрагмента и смещение в нем
+    struct Position {
+        qsizetype chunk = 0;
+        qsizetype offset = 0;
+    };
+
+    // Фрагмент, в котором должна лежать entry: первый, чья последняя запись
+    // не меньше entry, иначе последний
+    qsizetype chunkFor(const Entry& entry) const;
+    // Позиция index-й по порядку записи (index < size())
+    Position locate(qsizetype index) const;
+    const Entry& at(const Position& position) const { return chunks.at(position.chunk).at(position.offset); }
+    void advance(Position& position) const;
+    void retreat(Position& position) const;
+
+    // Дерево Фенвика по размерам фрагментов (индексы с 1)
+    void rebuildCounts();
+    void addCount(qsizetype chunk, qsizetype delta);
+
+    QList<QList<Entry>> chunks; // непустые, по возрастанию
+    QList<qsizetype> counts;
+    qsizetype total = 0;
+};
+
+#endif // SORTEDVIEW_H
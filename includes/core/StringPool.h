@@ -0,0 +1,47 @@
+// StringPool.h
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "core/TrigramIndex.h"
+
+// Пул интернированных строк (словарное кодирование колонки).
+// Каждое различное значение хранится один раз и получает 32-битный код;
+// коды стабильны, пока пул не очищен. Возвращаемые строки разделяют
+// данные с пулом, поэтому одинаковые значения не дублируются в памяти.
+// Для каждого значения один раз вычисляются ключ сортировки и свернутая
+// форма (TextFolding), свернутые значения индексируются по триграммам.
+class StringPool {
+public:
+    static constexpr quint32 NO_CODE = 0xFFFFFFFFu;
+
+    StringPool() = default;
+
+    // Код значения; новое значение добавляется в пул
+    quint32 intern(const QString& value);
+    // Код значения или NO_CODE, если такого значения нет
+    quint32 find(const QString& value) const { return codes.value(value, NO_CODE); }
+
+    const QString& value(quint32 code) const { return values.at(code); }
+    const QByteArray& sortKey(quint32 code) const { return sortKeys.at(code); }
+    qsizetype size() const { return values.size(); }
+    const QList<QString>& allValues() const { return values; }
+
+    // Таблица по кодам: содержит ли значение подстроку (без учета регистра и ё/е).
+    // Пустой запрос подходит ко всем значениям.
+    QList<bool> matchingCodes(const QString& foldedPattern) const;
+
+    void clear();
+
+private:
+    QHash<QString, quint32> codes;
+    QList<QString> values;
+    QList<QByteArray> sortKeys;
+    QList<QString> foldedValues;
+    TrigramIndex foldedIndex;
+};
+
+#endif // STRINGPOOL_H
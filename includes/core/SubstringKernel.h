@@ -0,0 +1,25 @@
+// SubstringKernel.h
+#ifndef SUBSTRINGKERNEL_H
+#define SUBSTRINGKERNEL_H
+
+#include <QString>
+
+// Поиск подстроки в уже свернутых строках UTF-16 (TextFolding::fold).
+// Векторный фильтр по первой и последней кодовой единице образца
+// (AVX2 или SSE2) с последующей проверкой середины; реализация выбирается
+// при первом вызове по возможностям процессора, иначе скалярный вариант.
+class SubstringKernel {
+public:
+    enum class Implementation { Scalar, Sse2, Avx2 };
+
+    static bool contains(const QString& text, const QString& pattern);
+    // Поиск заданной реализацией, для сравнения в бенчмарках; недоступная
+    // на этом процессоре реализация заменяется скалярной
+    static bool contains(const QString& text, const QString& pattern, Implementation implementation);
+    static bool isAvailable(Implementation implementation);
+
+    // Имя выбранной реализации ("avx2", "sse2" или "scalar")
+    static const char* implementationName();
+};
+
+#endif // SUBSTRINGKERNEL_H
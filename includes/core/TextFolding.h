@@ -0,0 +1,25 @@
+// TextFolding.h
+#ifndef TEXTFOLDING_H
+#define TEXTFOLDING_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+// Приведение строк к виду для сравнения без учета регистра
+class TextFolding {
+public:
+    // Нормализация Unicode (NFKC), свертка регистра и замена ё на е
+    static QString fold(const QString& value);
+
+    // Ключ сортировки: байты сравниваются memcmp и дают алфавитный порядок
+    // без учета регистра и различия ё/е. При равенстве свернутых строк
+    // порядок определяет исходная строка, поэтому ключ однозначен.
+    static QByteArray collationKey(const QString& value);
+
+    // Слова свернутой строки: последовательности букв и цифр, в порядке
+    // следования и с повторами
+    static QStringList words(const QString& foldedValue);
+};
+
+#endif // TEXTFOLDING_H
@@ -23,16 +23,16 @@ public:
           const QString& album, int year, const QString& genre, int duration);
     Track(int id, const TrackParams& params);
 
-    // Геттеры
+    // Геттеры (строки отдаются ссылкой: компараторы и поиск не копируют их)
     int getId() const { return id; }
-    QString getTitle() const { return title; }
-    QString getArtist() const { return artist; }
-    QString getAlbum() const { return album; }
+    const QString& getTitle() const { return title; }
+    const QString& getArtist() const { return artist; }
+    const QString& getAlbum() const { return album; }
     int getYear() const { return year; }
-    QString getGenre() const { return genre; }
+    const QString& getGenre() const { return genre; }
     int getDuration() const { return duration; }
     QString getFormattedDuration() const;
-    QString getFilePath() const { return filePath; }
+    const QString& getFilePath() const { return filePath; }
 
     // Сеттеры
     void setId(int newId) { id = newId; }
@@ -45,7 +45,6 @@ public:
     void setFilePath(const QString& newFilePath) { filePath = newFilePath; }
 
     // Вспомогательные методы
-    bool matchesSearch(const QString& searchTerm) const;
     bool isFromYandexMusic() const;
 
     // Перегрузка операторов сравнения
@@ -0,0 +1,89 @@
+// TrackColumns.h
+#ifndef TRACKCOLUMNS_H
+#define TRACKCOLUMNS_H
+
+#include "core/Track.h"
+#include "core/StringPool.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Колоночное (struct-of-arrays) хранилище треков.
+// Числовые поля лежат в плотных массивах int, поэтому фильтры по году и
+// длительности читают только нужные данные. Строковые колонки разделяют
+// данные с треками через implicit sharing. Исполнитель, альбом и жанр
+// закодированы словарем: в колонке хранится 32-битный код из StringPool,
+// поэтому сравнение на равенство и группировка работают с целыми числами.
+// Позиция (slot) в колонках совпадает с позицией трека в TrackRepository.
+class TrackColumns {
+public:
+    TrackColumns() = default;
+
+    // Изменение
+    void append(const Track& track);
+    void set(qsizetype slot, const Track& track);
+    void removeAt(qsizetype slot);
+    // Переставить все колонки: order[i] — текущая позиция элемента, который станет i-м
+    void permute(const QList<quint32>& order);
+    void clear();
+
+    // Сборка объекта Track по требованию
+    Track materialize(qsizetype slot) const;
+
+    qsizetype size() const { return idColumn.size(); }
+
+    // Колонки только для чтения
+    const QList<int>& ids() const { return idColumn; }
+    const QList<int>& years() const { return yearColumn; }
+    const QList<int>& durations() const { return durationColumn; }
+    const QStringList& titles() const { return titleColumn; }
+    const QStringList& filePaths() const { return filePathColumn; }
+    // Признак трека из Яндекс Музыки (Track::isFromYandexMusic)
+    const QList<bool>& yandexFlags() const { return yandexColumn; }
+    // Ключи сортировки названий, вычисляются при добавлении и изменении
+    const QList<QByteArray>& titleKeys() const { return titleKeyColumn; }
+    // Свернутые названия (TextFolding::fold) для поиска без выделения памяти
+    const QStringList& foldedTitles() const { return foldedTitleColumn; }
+
+    // Словарно-кодированные колонки
+    const QList<quint32>& artistCodes() const { return artistColumn; }
+    const QList<quint32>& albumCodes() const { return albumColumn; }
+    const QList<quint32>& genreCodes() const { return genreColumn; }
+    const StringPool& artistPool() const { return artistDictionary; }
+    const StringPool& albumPool() const { return albumDictionary; }
+    const StringPool& genrePool() const { return genreDictionary; }
+
+    // Статистика: сколько треков ссылается на каждый код словаря
+    const QList<qsizetype>& artistUsage() const { return artistCounts; }
+    const QList<qsizetype>& albumUsage() const { return albumCounts; }
+    const QList<qsizetype>& genreUsage() const { return genreCounts; }
+
+    const QString& artist(qsizetype slot) const { return artistDictionary.value(artistColumn.at(slot)); }
+    const QString& album(qsizetype slot) const { return albumDictionary.value(albumColumn.at(slot)); }
+    const QString& genre(qsizetype slot) const { return genreDictionary.value(genreColumn.at(slot)); }
+
+private:
+    static void countCode(QList<qsizetype>& counts, quint32 code, qsizetype delta);
+
+    QList<int> idColumn;
+    QList<int> yearColumn;
+    QList<int> durationColumn;
+    QStringList titleColumn;
+    QList<QByteArray> titleKeyColumn;
+    QStringList foldedTitleColumn;
+    QList<quint32> artistColumn;
+    QList<quint32> albumColumn;
+    QList<quint32> genreColumn;
+    QStringList filePathColumn;
+    QList<bool> yandexColumn;
+
+    StringPool artistDictionary;
+    StringPool albumDictionary;
+    StringPool genreDictionary;
+    QList<qsizetype> artistCounts;
+    QList<qsizetype> albumCounts;
+    QList<qsizetype> genreCounts;
+};
+
+#endif // TRACKCOLUMNS_H
@@ -0,0 +1,193 @@
+// TrackOrdering.h
+#ifndef TRACKORDERING_H
+#define TRACKORDERING_H
+
+#include "core/TrackColumns.h"
+#include "core/TrackSearchParams.h"
+
+// Сравнение позиций треков по колонкам репозитория, без копирования треков.
+// Строки сравниваются по ключам сортировки (TextFolding::collationKey):
+// ключи вычислены при добавлении трека, а сравнение сводится к memcmp.
+// Равные коды словаря означают равные ключи, поэтому сравниваются сначала коды.
+// Строгие порядки (withSpecLess, SpecLess) упорядочивают треки с равными
+// ключами по возрастанию id в обоих направлениях — так же, как SortedView,
+// поэтому окно результата не зависит от того, каким путем оно получено.
+class TrackOrdering {
+public:
+    // Вызвать visit с функцией "меньше" для ключа order. Ключ выбирается
+    // один раз, и каждая ветка получает свой встраиваемый компаратор.
+    template<typename Visitor>
+    static auto withLess(const TrackColumns& columns, TrackOrder order, Visitor&& visit) {
+        const QByteArray* titleKeys = columns.titleKeys().constData();
+        const quint32* artistCodes = columns.artistCodes().constData();
+        const StringPool& artists = columns.artistPool();
+
+        switch (order) {
+        case TrackOrder::Title:
+            return visit([titleKeys, artistCodes, &artists](qsizetype a, qsizetype b) {
+                const int compared = titleKeys[a].compare(titleKeys[b]);
+                if (compared != 0) {
+                    return compared < 0;
+                }
+                return artistCodes[a] != artistCodes[b] &&
+                       artists.sortKey(artistCodes[a]) < artists.sortKey(artistCodes[b]);
+            });
+        case TrackOrder::Artist:
+            return visit(codeThenTitle(artistCodes, artists, titleKeys));
+        case TrackOrder::Album:
+            return visit(codeThenTitle(columns.albumCodes().constData(), columns.albumPool(), titleKeys));
+        case TrackOrder::Genre:
+            return visit(codeThenTitle(columns.genreCodes().constData(), columns.genrePool(), titleKeys));
+        case TrackOrder::Year: {
+            const int* years = columns.years().constData();
+            return visit([years, titleKeys](qsizetype a, qsizetype b) {
+                if (years[a] != years[b]) {
+                    return years[a] < years[b];
+                }
+                return titleKeys[a] < titleKeys[b];
+            });
+        }
+        case TrackOrder::Duration: {
+            const int* durations = columns.durations().constData();
+            return visit([durations, titleKeys](qsizetype a, qsizetype b) {
+                if (durations[a] != durations[b]) {
+                    return durations[a] < durations[b];
+                }
+                return titleKeys[a] < titleKeys[b];
+            });
+        }
+        case TrackOrder::Catalog:
+            break;
+        }
+        // Порядок каталога совпадает с порядком позиций
+        return visit([](qsizetype a, qsizetype b) { return a < b; });
+    }
+
+    // Ключи spec до первого Catalog включительно: Catalog упорядочивает
+    // строго, и ключи после него ничего не решают
+    static QList<SortKey> effectiveSpec(const QList<SortKey>& spec) {
+        QList<SortKey> keys;
+        for (const SortKey& key : spec) {
+            keys.append(key);
+            if (key.field == TrackOrder::Catalog) {
+                break;
+            }
+        }
+        return keys;
+    }
+
+    // Вызвать visit со строгим полным порядком позиций для spec: один ключ
+    // сравнивается как в withLess, несколько — через SpecLess; при равенстве
+    // ключей решает id. Пустой spec — порядок каталога.
+    template<typename Visitor>
+    static auto withSpecLess(const TrackColumns& columns, const QList<SortKey>& spec, Visitor&& visit) {
+        const QList<SortKey> keys = effectiveSpec(spec);
+        if (keys.size() > 1) {
+            return visit(SpecLess(columns, keys));
+        }
+        const SortKey key = keys.isEmpty() ? SortKey{TrackOrder::Catalog, true} : keys.first();
+        const int* ids = columns.ids().constData();
+        return withLess(columns, key.field, [&visit, &key, ids](auto less) {
+            return visit([less, ids, ascending = key.ascending](qsizetype a, qsizetype b) {
+                if (ascending ? less(a, b) : less(b, a)) {
+                    return true;
+                }
+                if (ascending ? less(b, a) : less(a, b)) {
+                    return false;
+                }
+                return ids[a] < ids[b];
+            });
+        });
+    }
+
+    // Сравнение по списку ключей. Каждый ключ превращается в проекцию,
+    // которая ссылается на колонку (числа, ключи сортировки названий или коды
+    // словаря с их ключами сортировки), поэтому строки не копируются.
+    // При равенстве всех ключей решает id: порядок строгий и полный.
+    class SpecLess {
+    public:
+        SpecLess(const TrackColumns& columns, const QList<SortKey>& spec)
+            : ids(columns.ids().constData()) {
+            for (const SortKey& key : spec) {
+                Projection projection;
+                projection.ascending = key.ascending;
+                switch (key.field) {
+                case TrackOrder::Title:
+                    projection.bytes = columns.titleKeys().constData();
+                    break;
+                case TrackOrder::Artist:
+                    projection.codes = columns.artistCodes().constData();
+                    projection.pool = &columns.artistPool();
+                    break;
+                case TrackOrder::Album:
+                    projection.codes = columns.albumCodes().constData();
+                    projection.pool = &columns.albumPool();
+                    break;
+                case TrackOrder::Genre:
+                    projection.codes = columns.genreCodes().constData();
+                    projection.pool = &columns.genrePool();
+                    break;
+                case TrackOrder::Year:
+                    projection.numbers = columns.years().constData();
+                    break;
+                case TrackOrder::Duration:
+                    projection.numbers = columns.durations().constData();
+                    break;
+                case TrackOrder::Catalog:
+                    break;
+                }
+                projections.append(projection);
+            }
+        }
+
+        bool operator()(qsizetype a, qsizetype b) const {
+            for (const Projection& projection : projections) {
+                const int order = projection.compare(a, b);
+                if (order != 0) {
+                    return projection.ascending ? order < 0 : order > 0;
+                }
+            }
+            return ids[a] < ids[b];
+        }
+
+    private:
+        struct Projection {
+            const int* numbers = nullptr;
+            const QByteArray* bytes = nullptr;
+            const quint32* codes = nullptr;
+            const StringPool* pool = nullptr;
+            bool ascending = true;
+
+            // Трехзначное сравнение: < 0, 0 или > 0
+            int compare(qsizetype a, qsizetype b) const {
+                if (numbers) {
+                    return (numbers[a] > numbers[b]) - (numbers[a] < numbers[b]);
+                }
+                if (bytes) {
+                    return bytes[a].compare(bytes[b]);
+                }
+                if (codes) {
+                    return codes[a] == codes[b] ? 0 : pool->sortKey(codes[a]).compare(pool->sortKey(codes[b]));
+                }
+                // Ключ Catalog: порядок позиций
+                return (a > b) - (a < b);
+            }
+        };
+
+        QList<Projection> projections;
+        const int* ids;
+    };
+
+private:
+    // Код словарной колонки (равные коды — равные строки), затем название
+    static auto codeThenTitle(const quint32* codes, const StringPool& pool, const QByteArray* titleKeys) {
+        return [codes, &pool, titleKeys](qsizetype a, qsizetype b) {
+            if (codes[a] != codes[b]) {
+                return pool.sortKey(codes[a]) < pool.sortKey(codes[b]);
+            }
+            return titleKeys[a] < titleKeys[b];
+        };
+    }
+};
+
+#endif // TRACKORDERING_H
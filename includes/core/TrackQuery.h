@@ -0,0 +1,57 @@
+// TrackQuery.h
+#ifndef TRACKQUERY_H
+#define TRACKQUERY_H
+
+#include "core/TrackSearchParams.h"
+#include <QList>
+#include <QString>
+#include <climits>
+
+// Разобранный запрос языка поиска, например
+//   artist:metallica year:1986..1991 dur:>300 -genre:live
+// Поля: title, artist, album, genre (подстрока без учета регистра и ё/е),
+// year, dur (число, a..b, a.., ..b, >n, >=n, <n, <=n; длительность также
+// в виде м:сс) и source:local|yandex. Слово без поля ищется в названии,
+// исполнителе, альбоме и жанре; значения с пробелами берутся в кавычки.
+// Условия через пробел (или AND) объединяются по И, OR и | — по ИЛИ,
+// минус и NOT отрицают условие, скобки группируют.
+// Запрос хранится плоским деревом: узлы ссылаются на потомков по индексу.
+class TrackQuery {
+public:
+    enum class Field { Any, Title, Artist, Album, Genre, Year, Duration, Source };
+    enum class NodeType { Match, And, Or, Not };
+
+    struct Node {
+        NodeType type = NodeType::Match;
+        Field field = Field::Any;
+        QString text;               // свернутая подстрока строкового поля
+        int min = INT_MIN;          // включительные границы года или длительности
+        int max = INT_MAX;
+        TrackSource source = TrackSource::Any;
+        qsizetype left = -1;        // потомки And/Or, единственный потомок Not — left
+        qsizetype right = -1;
+    };
+
+    TrackQuery() = default;
+
+    // Разбор строки запроса; ошибки синтаксиса — ParseException с позицией
+    static TrackQuery parse(const QString& query);
+
+    const QList<Node>& nodes() const { return nodeList; }
+    // Корневой узел или -1 для пустого запроса (подходят все треки)
+    qsizetype root() const { return rootNode; }
+    bool isEmpty() const { return rootNode < 0; }
+
+    // Каноническая запись: одинаковые по смыслу записи запроса совпадают
+    QString toString() const;
+
+private:
+    friend class TrackQueryParser;
+
+    QString nodeToString(qsizetype node) const;
+
+    QList<Node> nodeList;
+    qsizetype rootNode = -1;
+};
+
+#endif // TRACKQUERY_H
@@ -3,7 +3,17 @@
 #define TRACKREPOSITORY_H
 
 #include "core/Track.h"
+#include "core/TrackColumns.h"
+#include "core/TrigramIndex.h"
+#include "core/FuzzyIndex.h"
+#include "core/RelevanceIndex.h"
+#include "core/SortedView.h"
+#include "core/RangeIndex.h"
+#include "core/RoaringBitmap.h"
+#include "core/TrackSearchParams.h"
+#include "core/TrackView.h"
 #include <QList>
+#include <QHash>
 
 class TrackRepository {
 public:
@@ -19,22 +29,85 @@ public:
     bool removeTrack(int id);
     bool updateTrack(int id, const Track& updatedTrack);
 
-    // Получение треков
-    Track* findTrackById(int id);
+    // Получение треков (изменение только через updateTrack, чтобы колонки
+    // и индексы оставались согласованными)
     const Track* findTrackById(int id) const;
-    QList<Track> findAllTracks() const { return tracks; }
+    QList<Track> findAllTracks() const { return snapshot(); }
+
+    // Представление хранилища без копирования (действительно до изменения репозитория)
+    TrackView tracksView() const { return TrackView(tracks); }
+    // Снимок каталога: общий (implicit sharing) QList, который не меняется
+    // при последующих изменениях репозитория. Обходите его как const,
+    // иначе неконстантный доступ вызовет полную копию.
+    QList<Track> snapshot() const { return tracks; }
+    // Колоночное представление тех же треков (позиции совпадают с tracksView())
+    const TrackColumns& trackColumns() const { return columns; }
+    // Позиция трека в хранилище или -1
+    qsizetype findSlot(int id) const { return idIndex.value(id, -1); }
+    // Триграммный индекс свернутых названий (ключ — id трека)
+    const TrigramIndex& titleTrigrams() const { return titleIndex; }
+    // Позиции треков, название которых может содержать свернутую подстроку,
+    // по возрастанию. Возвращает false, если запрос короче триграммы.
+    bool titleCandidateSlots(const QString& foldedTitle, QList<qsizetype>& slots) const;
+    // Индекс слов названий и исполнителей для поиска с опечатками (ключ — id трека)
+    const FuzzyIndex& fuzzyWords() const { return wordIndex; }
+    // Полнотекстовый индекс названия, исполнителя, альбома и жанра (ключ — id трека)
+    const RelevanceIndex& relevanceIndex() const { return textIndex; }
+    // Упорядоченные индексы года и длительности (ключ -> id треков)
+    const RangeIndex& yearRangeIndex() const { return yearIndex; }
+    const RangeIndex& durationRangeIndex() const { return durationIndex; }
+    // Битовые индексы колонок с малым числом значений (множества id треков)
+    const RoaringBitmap& genreBitmap(quint32 genreCode) const;
+    // Треки источника TrackSource::Local или TrackSource::YandexMusic
+    const RoaringBitmap& sourceBitmap(TrackSource source) const;
+    // Id треков окна в порядке window.orderBy без сортировки хранилища.
+    // Порядки по названию, исполнителю, году, длительности, альбому и жанру поддерживаются
+    // при изменениях после первого запроса; равные ключи идут по id.
+    QList<int> orderedIds(const ResultWindow& window) const;
+    // Позиции треков с переданными id, по возрастанию
+    QList<qsizetype> slotsOf(const QList<int>& ids) const;
 
     // Статистика
     int getTrackCount() const { return tracks.size(); }
     int getNextId() const { return nextId; }
+    // Номер версии данных: растет при каждом изменении, включая сортировку
+    quint64 getGeneration() const { return generation; }
     void updateNextId();
 
-    // Для сортировки
-    void setTracks(const QList<Track>& newTracks);
+    // Для сортировки: order[i] — текущая позиция трека, который станет i-м
+    void applyPermutation(const QList<quint32>& order);
 
 private:
+    // Добавить трек в конец хранилища, колонок и индекса
+    void appendTrack(const Track& track);
+    // Добавить или убрать трек из битовых индексов жанра и источника
+    void indexBitmaps(qsizetype slot, bool add);
+    // Свернутые название и исполнитель трека для индекса слов
+    QString wordText(qsizetype slot) const;
+    // Добавить трек в полнотекстовый индекс (прежние слова трека заменяются)
+    void indexText(qsizetype slot);
+    // Запись упорядоченного представления для трека в позиции slot
+    SortedView::Entry viewEntry(TrackOrder order, qsizetype slot) const;
+    // Добавить трек во все упорядоченные представления или убрать из них
+    void indexViews(qsizetype slot, bool add);
+    // Пересобрать индекс id -> позиция начиная с указанной позиции
+    void reindexFrom(qsizetype slot);
+
     QList<Track> tracks;
+    TrackColumns columns;
+    QHash<int, qsizetype> idIndex; // id трека -> позиция в tracks
+    TrigramIndex titleIndex;
+    FuzzyIndex wordIndex;
+    RelevanceIndex textIndex;
+    // Представления по TrackOrder::Title..Genre; строятся при первом запросе
+    mutable QList<SortedView> sortedViews;
+    RangeIndex yearIndex;
+    RangeIndex durationIndex;
+    QList<RoaringBitmap> genreBitmaps; // код жанра -> id треков
+    RoaringBitmap localTracks;
+    RoaringBitmap yandexTracks;
     int nextId = 1;
+    quint64 generation = 0;
 };
 
 #endif // TRACKREPOSITORY_H
@@ -3,6 +3,14 @@
 #define TRACKSEARCHPARAMS_H
 
 #include <QString>
+#include <QtGlobal>
+
+// Источник трека: локальный файл или Яндекс Музыка
+enum class TrackSource {
+    Any,
+    Local,
+    YandexMusic
+};
 
 // Структура для параметров поиска треков
 struct TrackSearchParams {
@@ -14,6 +22,40 @@ struct TrackSearchParams {
     int maxYear = 0;
     int minDuration = 0;
     int maxDuration = 0;
+    TrackSource source = TrackSource::Any;
+};
+
+// Ключ упорядочивания результатов поиска
+enum class TrackOrder {
+    Catalog,
+    Title,
+    Artist,
+    Year,
+    Duration,
+    Album,
+    Genre
+};
+
+// Окно результатов: порядок и страница (limit < 0 означает "до конца")
+struct ResultWindow {
+    TrackOrder orderBy = TrackOrder::Catalog;
+    bool ascending = true;
+    qsizetype offset = 0;
+    qsizetype limit = -1;
+
+    // Границы окна [begin, end) в списке из count элементов
+    qsizetype begin(qsizetype count) const { return qBound(qsizetype(0), offset, count); }
+    qsizetype end(qsizetype count) const {
+        const qsizetype first = begin(count);
+        return limit < 0 ? count : first + qMin(limit, count - first);
+    }
+};
+
+// Один ключ многоключевой сортировки; ключи сравниваются по порядку,
+// следующий решает только при равенстве предыдущих
+struct SortKey {
+    TrackOrder field = TrackOrder::Title;
+    bool ascending = true;
 };
 
 // Структура для параметров добавления трека
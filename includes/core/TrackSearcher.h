@@ -4,6 +4,11 @@
 
 #include "core/Track.h"
 #include "core/TrackSearchParams.h"
+#include "core/FilterPlanner.h"
+#include "core/SearchPlan.h"
+#include "core/SearchSession.h"
+#include "core/FuzzyIndex.h"
+#include "core/TrackQuery.h"
 #include <QList>
 #include <QString>
 
@@ -23,11 +28,50 @@ public:
     QList<Track> findTracksByGenre(const QString& genre) const;
     QList<Track> findTracksByYearRange(int startYear, int endYear) const;
 
+    // Поиск по запросу вида "artist:metallica year:1986..1991 -genre:live"
+    // (синтаксис — TrackQuery); ошибки разбора — ParseException
+    QList<Track> searchByQuery(const QString& query) const;
+    // Позиции треков, подходящих под разобранный запрос, в порядке каталога
+    QList<qsizetype> querySlots(const TrackQuery& query) const;
+
+    // Полнотекстовый поиск по словам названия, исполнителя, альбома и жанра,
+    // самые релевантные (BM25) первыми; limit < 0 — все совпадения
+    QList<Track> rankedSearch(const QString& query, qsizetype limit = -1) const;
+
+    // Поиск с опечатками по словам названия и исполнителя (до maxDistance
+    // правок на слово), ближайшие совпадения первыми
+    QList<Track> fuzzySearch(const QString& query, int maxDistance = FuzzyIndex::MAX_DISTANCE) const;
+
     // Комбинированный поиск с фильтрами
     QList<Track> searchTracksWithFilters(const TrackSearchParams& params) const;
+    // Выполнить поиск с фильтрами и вернуть выбранный план со временем шагов
+    SearchPlan explain(const TrackSearchParams& params) const;
+    // Поиск без копирования треков: позиции совпавших треков в порядке каталога
+    QList<qsizetype> searchSlots(const QString& searchTerm) const;
+    QList<qsizetype> searchSlotsWithFilters(const TrackSearchParams& params) const;
+    // Id треков окна результатов. Для страницы из limit треков держится куча
+    // из offset + limit лучших позиций, остальные позиции только сравниваются.
+    QList<int> pageIds(const QList<qsizetype>& slots, const ResultWindow& window) const;
+    // Id первых count позиций slots в порядке spec: частичная выборка
+    // (nth_element) за O(n + count log count) вместо сортировки всех позиций
+    QList<int> topIds(QList<qsizetype> slots, const QList<SortKey>& spec, qsizetype count) const;
+    // То же по всему каталогу
+    QList<int> topIds(const QList<SortKey>& spec, qsizetype count) const;
+    // Сессия поиска по мере набора, уточняющая прошлые результаты
+    SearchSession startSession() const;
+
+    // Порог параллельного сканирования: меньшие наборы проверяются
+    // последовательно в вызывающем потоке
+    static constexpr qsizetype DEFAULT_PARALLEL_THRESHOLD = 50000;
+    void setParallelThreshold(qsizetype threshold);
+    qsizetype getParallelThreshold() const;
 
 private:
+    QList<Track> runFilters(const TrackSearchParams& params, SearchPlan* plan) const;
+
     const TrackRepository& repository;
+    FilterPlanner planner;
+    qsizetype parallelThreshold;
 };
 
 #endif // TRACKSEARCHER_H
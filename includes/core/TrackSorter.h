@@ -2,20 +2,33 @@
 #ifndef TRACKSORTER_H
 #define TRACKSORTER_H
 
+#include "core/TrackSearchParams.h"
+
 class TrackRepository;
 
 class TrackSorter {
 public:
     explicit TrackSorter(TrackRepository& repository);
 
-    // Сортировка
+    // Сортировка (треки с равными ключами идут по возрастанию id)
     void sortByTitle(bool ascending = true);
     void sortByArtist(bool ascending = true);
     void sortByYear(bool ascending = true);
     void sortByDuration(bool ascending = true);
+    // Сортировка по нескольким ключам, например исполнитель, альбом, год по убыванию
+    void sortBy(const QList<SortKey>& spec);
+
+    // Порог параллельной сортировки: меньшие каталоги сортируются
+    // последовательно в вызывающем потоке
+    static constexpr qsizetype DEFAULT_PARALLEL_THRESHOLD = 200000;
+    void setParallelThreshold(qsizetype threshold);
+    qsizetype getParallelThreshold() const;
 
 private:
+    void sortByKey(TrackOrder order, bool ascending);
+
     TrackRepository& repository;
+    qsizetype parallelThreshold;
 };
 
 #endif // TRACKSORTER_H
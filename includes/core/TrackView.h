@@ -0,0 +1,38 @@
+// TrackView.h
+#ifndef TRACKVIEW_H
+#define TRACKVIEW_H
+
+#include "core/Track.h"
+#include <QList>
+
+// Невладеющее представление списка треков только для чтения.
+// Не копирует треки и не вызывает detach() общего QList, поэтому обход
+// каталога не стоит полной копии. Представление действительно до первого
+// изменения репозитория; если нужна стабильность, используйте снимок
+// (TrackRepository::snapshot()).
+class TrackView {
+public:
+    using const_iterator = QList<Track>::const_iterator;
+    using value_type = Track;
+
+    explicit TrackView(const QList<Track>& tracks) : tracks(&tracks) {}
+
+    // Итераторы
+    const_iterator begin() const { return tracks->cbegin(); }
+    const_iterator end() const { return tracks->cend(); }
+    const_iterator cbegin() const { return tracks->cbegin(); }
+    const_iterator cend() const { return tracks->cend(); }
+
+    // Доступ к трекам
+    const Track& at(qsizetype index) const { return tracks->at(index); }
+    const Track& operator[](qsizetype index) const { return tracks->at(index); }
+
+    // Размер
+    qsizetype size() const { return tracks->size(); }
+    bool isEmpty() const { return tracks->isEmpty(); }
+
+private:
+    const QList<Track>* tracks;
+};
+
+#endif // TRACKVIEW_H
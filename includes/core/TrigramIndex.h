@@ -0,0 +1,38 @@
+// TrigramIndex.h
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// Инвертированный индекс по триграммам (тройкам кодовых единиц UTF-16).
+// Каждой триграмме соответствует отсортированный список ключей документов
+// (id трека или код значения словаря). Строки индексируются в свернутом виде
+// (TextFolding::fold), запрос тоже должен быть свернут.
+class TrigramIndex {
+public:
+    // Минимальная длина запроса, для которой индекс может отобрать кандидатов
+    static constexpr qsizetype GRAM_SIZE = 3;
+
+    TrigramIndex() = default;
+
+    void insert(int key, const QString& foldedText);
+    void remove(int key, const QString& foldedText);
+    void clear();
+
+    // Отсортированные ключи документов, содержащих все триграммы запроса.
+    // Это надмножество совпадений: кандидатов нужно проверить.
+    // Возвращает false, если запрос короче GRAM_SIZE и индекс неприменим.
+    bool candidates(const QString& foldedPattern, QList<int>& keys) const;
+    // Верхняя оценка числа кандидатов без пересечения списков: длина
+    // самого короткого списка. Возвращает false, если индекс неприменим.
+    bool estimate(const QString& foldedPattern, qsizetype& count) const;
+
+private:
+    static QList<quint64> gramsOf(const QString& foldedText);
+
+    QHash<quint64, QList<int>> postings;
+};
+
+#endif // TRIGRAMINDEX_H
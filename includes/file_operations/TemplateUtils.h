@@ -48,7 +48,9 @@ void sort(Container& container, Compare comp) {
     std::sort(container.begin(), container.end(), comp);
 }
 
-// Шаблонный класс для сравнения по полю объекта
+// Шаблонный класс для сравнения по полю объекта. Значение геттера берется
+// по ссылке, если геттер возвращает ссылку (const QString&), и не копируется.
+// Убывание получается перестановкой аргументов: нужен только operator<.
 template<typename T, typename MemberType>
 class MemberComparator {
 public:
@@ -58,9 +60,9 @@ public:
         : memberPtr(member), ascending(ascending) {}
     
     bool operator()(const T& a, const T& b) const {
-        MemberType valA = (a.*memberPtr)();
-        MemberType valB = (b.*memberPtr)();
-        return ascending ? (valA < valB) : (valA > valB);
+        decltype(auto) valA = (a.*memberPtr)();
+        decltype(auto) valB = (b.*memberPtr)();
+        return ascending ? (valA < valB) : (valB < valA);
     }
     
 private:
@@ -83,9 +85,9 @@ public:
         : compareFunc(func), ascending(ascending) {}
     
     bool operator()(const T& a, const T& b) const {
-        auto valA = compareFunc(a);
-        auto valB = compareFunc(b);
-        return ascending ? (valA < valB) : (valA > valB);
+        decltype(auto) valA = compareFunc(a);
+        decltype(auto) valB = compareFunc(b);
+        return ascending ? (valA < valB) : (valB < valA);
     }
     
 private:
@@ -30,6 +30,8 @@
 #include <QDialog>
 #include <QListWidget>
 #include <QProgressBar>
+#include <QTimer>
+#include <QSet>
 
 class MainWindow : public QMainWindow
 {
@@ -44,6 +46,9 @@ private slots:
     void showAddTrack();
     void addNewTrack();
     void searchTracks();
+    void searchByQuery();
+    void applyLiveFilter();
+    void sortByHeader(int column);
     void onMP3FileSelected();
     void openTrackFile(int row, int column);
     void autoSaveCatalog() const;
@@ -62,9 +67,19 @@ private:
     // Основные компоненты
     QStackedWidget *stackedWidget;
     MusicCatalog catalog;
+    SearchSession liveSearch;
+    QTimer *liveFilterTimer = nullptr;
     int currentTrackId = -1;
     MP3FileManager mp3Manager;
     TrackTableHighlighter* tableHighlighter = nullptr;
+    // Ключи сортировки таблицы (щелчок и Shift+щелчок по заголовку)
+    QList<SortKey> tableSortSpec = {SortKey{TrackOrder::Title, true}};
+    // Последний порядок строк для нескольких ключей и версия каталога, для которой он посчитан
+    QList<int> multiKeyOrder;
+    quint64 multiKeyOrderGeneration = 0;
+    bool multiKeyOrderValid = false;
+    // Подсвеченные результаты поиска, восстанавливаются после пересортировки
+    QSet<int> highlightedIds;
 
     // Экраны
     QWidget *createMainCatalogScreen();
@@ -73,9 +88,13 @@ private:
 
     // Вспомогательные методы
     void updateTrackTable();
-    void updateTrackTable(const QList<Track>& tracksToDisplay);
     void clearAddTrackForm();
-    void populateTrackTable(const QList<Track>& tracks);
+    // Строки таблицы в порядке trackIds
+    void populateTrackTable(const QList<int>& trackIds);
+    QList<int> tableTrackIds();
+    void updateSourceFilterCounts();
+    void highlightResults(const QSet<int>& ids);
+    TrackSearchParams currentSearchParams() const;
     void fillFormFromParsedFileName(const QString& fileBaseName, const QString& title, 
                                     const QString& artist, const QString& parsedAlbum,
                                     int parsedYear, const QString& parsedGenre, int parsedDuration);
@@ -84,10 +103,12 @@ private:
     // Структуры для группировки UI элементов
     struct SearchUI {
         QTableWidget *trackTable = nullptr;
+        QLineEdit *searchQueryEdit = nullptr;
         QLineEdit *searchTitleEdit = nullptr;
         QLineEdit *searchArtistEdit = nullptr;
         QLineEdit *searchAlbumEdit = nullptr;
         QLineEdit *searchGenreEdit = nullptr;
+        QComboBox *searchSourceEdit = nullptr;
         QSpinBox *searchMinYear = nullptr;
         QSpinBox *searchMaxYear = nullptr;
         QSpinBox *searchMinDuration = nullptr;
@@ -0,0 +1,760 @@
+// FilterPlanner.cpp
+#include "core/FilterPlanner.h"
+#include "core/TrackRepository.h"
+#include "core/TrackColumns.h"
+#include "core/TextFolding.h"
+#include "core/SubstringKernel.h"
+#include "core/ParallelFor.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+namespace {
+    // Относительная стоимость проверки одной позиции
+    constexpr double RANGE_COST = 1.0;
+    constexpr double CODE_COST = 1.5;
+    constexpr double TITLE_COST = 12.0;
+    // Получение позиции из индекса: поиск по id и сортировка
+    constexpr double INDEX_ROW_COST = 4.0;
+    // Объединение корзин битового индекса в пересчете на одну строку
+    constexpr double BITMAP_ROW_COST = 0.1;
+
+    // Сколько позиций проверяется для выборочной оценки селективности
+    constexpr qsizetype SAMPLE_SIZE = 1024;
+
+    // Диапазон числового фильтра; значения "не задано" раскрываются в INT_MIN/INT_MAX
+    struct IntRange {
+        int min = INT_MIN;
+        int max = INT_MAX;
+
+        bool contains(int value) const { return value >= min && value <= max; }
+        bool isUnbounded() const { return min == INT_MIN && max == INT_MAX; }
+    };
+
+    IntRange yearRange(const TrackSearchParams& params) {
+        IntRange range;
+        if (params.minYear >= 1900) {
+            range.min = params.minYear;
+        }
+        if (params.maxYear <= 2100 && params.maxYear >= 1900) {
+            range.max = params.maxYear;
+        }
+        return range;
+    }
+
+    IntRange durationRange(const TrackSearchParams& params) {
+        IntRange range;
+        if (params.minDuration > 1) {
+            range.min = params.minDuration;
+        }
+        if (params.maxDuration < 3600) {
+            range.max = params.maxDuration;
+        }
+        return range;
+    }
+
+    QString rangeDetail(const char* column, const IntRange& range) {
+        return QString("%1 in [%2, %3]").arg(column)
+            .arg(range.min == INT_MIN ? QString("-inf") : QString::number(range.min))
+            .arg(range.max == INT_MAX ? QString("+inf") : QString::number(range.max));
+    }
+
+    enum class AccessPath { FullScan, TrigramIndex, BitmapIndex };
+
+    QString accessPathName(AccessPath path) {
+        switch (path) {
+        case AccessPath::TrigramIndex:
+            return "trigram index";
+        case AccessPath::BitmapIndex:
+            return "bitmap index";
+        case AccessPath::FullScan:
+            break;
+        }
+        return "full scan";
+    }
+
+    enum class PredicateKind { Year, Duration, Source, Artist, Album, Genre, Title };
+
+    // Условия, на которые точно отвечают битовые индексы репозитория
+    bool hasBitmap(PredicateKind kind) {
+        return kind == PredicateKind::Year || kind == PredicateKind::Duration ||
+               kind == PredicateKind::Source || kind == PredicateKind::Genre;
+    }
+
+    // Условие поиска с оценками планировщика
+    struct Predicate {
+        PredicateKind kind;
+        QString detail;
+        double selectivity;
+        double cost;
+
+        // Чем меньше ранг, тем раньше выгодно проверять условие
+        double rank() const {
+            return selectivity >= 1.0 ? std::numeric_limits<double>::infinity()
+                                      : cost / (1.0 - selectivity);
+        }
+    };
+
+    // Данные запроса, общие для всех шагов
+    struct FilterContext {
+        const TrackColumns& columns;
+        IntRange years;
+        IntRange durations;
+        QList<bool> artistMatches;
+        QList<bool> albumMatches;
+        QList<bool> genreMatches;
+        QString foldedTitle;
+        TrackSource source;
+    };
+
+    // Вызвать visit с функцией проверки позиции для условия kind.
+    // Проверка выбирается один раз на шаг, а не на каждую строку.
+    template<typename Visitor>
+    auto withTest(const FilterContext& context, PredicateKind kind, Visitor visit) {
+        const TrackColumns& columns = context.columns;
+        switch (kind) {
+        case PredicateKind::Year: {
+            const int* years = columns.years().constData();
+            const IntRange range = context.years;
+            return visit([years, range](qsizetype slot) { return range.contains(years[slot]); });
+        }
+        case PredicateKind::Duration: {
+            const int* durations = columns.durations().constData();
+            const IntRange range = context.durations;
+            return visit([durations, range](qsizetype slot) { return range.contains(durations[slot]); });
+        }
+        case PredicateKind::Source: {
+            const QList<bool>& flags = columns.yandexFlags();
+            const bool yandex = context.source == TrackSource::YandexMusic;
+            return visit([&flags, yandex](qsizetype slot) { return flags.at(slot) == yandex; });
+        }
+        case PredicateKind::Artist: {
+            const quint32* codes = columns.artistCodes().constData();
+            const QList<bool>& matches = context.artistMatches;
+            return visit([codes, &matches](qsizetype slot) { return matches.at(codes[slot]); });
+        }
+        case PredicateKind::Album: {
+            const quint32* codes = columns.albumCodes().constData();
+            const QList<bool>& matches = context.albumMatches;
+            return visit([codes, &matches](qsizetype slot) { return matches.at(codes[slot]); });
+        }
+        case PredicateKind::Genre: {
+            const quint32* codes = columns.genreCodes().constData();
+            const QList<bool>& matches = context.genreMatches;
+            return visit([codes, &matches](qsizetype slot) { return matches.at(codes[slot]); });
+        }
+        case PredicateKind::Title:
+            break;
+        }
+        const QString* titles = columns.foldedTitles().constData();
+        const QString& pattern = context.foldedTitle;
+        return visit([titles, &pattern](qsizetype slot) {
+            return SubstringKernel::contains(titles[slot], pattern);
+        });
+    }
+
+    // Биты дешевых условий в маске слитой проверки (название в нее не входит)
+    enum PredicateBit : unsigned {
+        YEAR_BIT = 1u << 0,
+        DURATION_BIT = 1u << 1,
+        SOURCE_BIT = 1u << 2,
+        ARTIST_BIT = 1u << 3,
+        ALBUM_BIT = 1u << 4,
+        GENRE_BIT = 1u << 5
+    };
+    constexpr unsigned FUSED_MASK_COUNT = 1u << 6;
+
+    unsigned predicateBit(PredicateKind kind) {
+        switch (kind) {
+        case PredicateKind::Year:
+            return YEAR_BIT;
+        case PredicateKind::Duration:
+            return DURATION_BIT;
+        case PredicateKind::Source:
+            return SOURCE_BIT;
+        case PredicateKind::Artist:
+            return ARTIST_BIT;
+        case PredicateKind::Album:
+            return ALBUM_BIT;
+        case PredicateKind::Genre:
+            return GENRE_BIT;
+        case PredicateKind::Title:
+            break;
+        }
+        return 0;
+    }
+
+    // Указатели на колонки и таблицы совпадений для слитой проверки
+    struct FusedColumns {
+        const int* years;
+        IntRange yearRange;
+        const int* durations;
+        IntRange durationRange;
+        const bool* yandexFlags;
+        bool yandex;
+        const quint32* artistCodes;
+        const bool* artistMatches;
+        const quint32* albumCodes;
+        const bool* albumMatches;
+        const quint32* genreCodes;
+        const bool* genreMatches;
+    };
+
+    FusedColumns fusedColumns(const FilterContext& context) {
+        const TrackColumns& columns = context.columns;
+        return FusedColumns{columns.years().constData(), context.years,
+                            columns.durations().constData(), context.durations,
+                            columns.yandexFlags().constData(), context.source == TrackSource::YandexMusic,
+                            columns.artistCodes().constData(), context.artistMatches.constData(),
+                            columns.albumCodes().constData(), context.albumMatches.constData(),
+                            columns.genreCodes().constData(), context.genreMatches.constData()};
+    }
+
+    // Проверка всех условий маски за один проход по строке в порядке битов
+    // (для шагов, где этот порядок совпадает с рангом). Маска известна
+    // при компиляции: в теле цикла остаются только активные сравнения,
+    // без проверок "условие задано" и промежуточных списков позиций.
+    template<unsigned Mask>
+    struct FusedTest {
+        const FusedColumns* fused;
+
+        bool operator()(qsizetype slot) const {
+            if constexpr ((Mask & YEAR_BIT) != 0) {
+                if (!fused->yearRange.contains(fused->years[slot])) {
+                    return false;
+                }
+            }
+            if constexpr ((Mask & DURATION_BIT) != 0) {
+                if (!fused->durationRange.contains(fused->durations[slot])) {
+                    return false;
+                }
+            }
+            if constexpr ((Mask & SOURCE_BIT) != 0) {
+                if (fused->yandexFlags[slot] != fused->yandex) {
+                    return false;
+                }
+            }
+            if constexpr ((Mask & ARTIST_BIT) != 0) {
+                if (!fused->artistMatches[fused->artistCodes[slot]]) {
+                    return false;
+                }
+            }
+            if constexpr ((Mask & ALBUM_BIT) != 0) {
+                if (!fused->albumMatches[fused->albumCodes[slot]]) {
+                    return false;
+                }
+            }
+            if constexpr ((Mask & GENRE_BIT) != 0) {
+                if (!fused->genreMatches[fused->genreCodes[slot]]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Вызвать visit со специализацией FusedTest для маски mask: выбор среди
+    // FUSED_MASK_COUNT экземпляров шаблона делается один раз на шаг плана
+    template<unsigned Mask = 0, typename Visitor>
+    auto withFusedTest(const FusedColumns& fused, unsigned mask, Visitor& visit) {
+        if constexpr (Mask + 1 < FUSED_MASK_COUNT) {
+            if (mask != Mask) {
+                return withFusedTest<Mask + 1>(fused, mask, visit);
+            }
+        }
+        return visit(FusedTest<Mask>{&fused});
+    }
+
+    // Слитая проверка в порядке, выбранном планировщиком: условия идут по
+    // рангу, поэтому самое отсекающее проверяется первым. Порядок задается
+    // при выполнении; переход по kinds на каждой строке одинаков и хорошо
+    // предсказывается.
+    struct RankedFusedTest {
+        static constexpr int MAX_PREDICATES = 6;
+
+        const FusedColumns* fused;
+        std::array<PredicateKind, MAX_PREDICATES> kinds;
+        int count;
+
+        bool operator()(qsizetype slot) const {
+            for (int i = 0; i < count; ++i) {
+                if (!passes(kinds[i], slot)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool passes(PredicateKind kind, qsizetype slot) const {
+            switch (kind) {
+            case PredicateKind::Year:
+                return fused->yearRange.contains(fused->years[slot]);
+            case PredicateKind::Duration:
+                return fused->durationRange.contains(fused->durations[slot]);
+            case PredicateKind::Source:
+                return fused->yandexFlags[slot] == fused->yandex;
+            case PredicateKind::Artist:
+                return fused->artistMatches[fused->artistCodes[slot]];
+            case PredicateKind::Album:
+                return fused->albumMatches[fused->albumCodes[slot]];
+            case PredicateKind::Genre:
+                return fused->genreMatches[fused->genreCodes[slot]];
+            case PredicateKind::Title:
+                break;
+            }
+            return true;
+        }
+    };
+
+    // Доля подходящих строк по равномерной выборке позиций
+    template<typename Test>
+    double sampledSelectivity(qsizetype count, Test test) {
+        if (count == 0) {
+            return 0.0;
+        }
+        const qsizetype samples = std::min(count, SAMPLE_SIZE);
+        qsizetype hits = 0;
+        for (qsizetype i = 0; i < samples; ++i) {
+            if (test(i * count / samples)) {
+                ++hits;
+            }
+        }
+        return static_cast<double>(hits) / samples;
+    }
+
+    // Точная доля строк, код которых отмечен в таблице совпадений
+    double codeSelectivity(const QList<bool>& matches, const QList<qsizetype>& usage, qsizetype rows) {
+        if (rows == 0) {
+            return 0.0;
+        }
+        qsizetype matched = 0;
+        const qsizetype codes = std::min(matches.size(), usage.size());
+        for (qsizetype code = 0; code < codes; ++code) {
+            if (matches.at(code)) {
+                matched += usage.at(code);
+            }
+        }
+        return static_cast<double>(matched) / rows;
+    }
+
+    // Отобрать позиции slotAt(0..count), прошедшие проверку, в исходном порядке.
+    // Большие входы делятся на фрагменты и проверяются в глобальном пуле потоков;
+    // результаты фрагментов склеиваются по порядку.
+    template<typename SlotAt, typename Test>
+    QList<qsizetype> selectSlots(qsizetype count, SlotAt slotAt, Test test, qsizetype parallelThreshold) {
+        const qsizetype chunkCount = count < parallelThreshold ? 1 : ParallelFor::chunkCount(count);
+        const qsizetype chunkSize = chunkCount == 1 ? count : (count + chunkCount - 1) / chunkCount;
+
+        // Буферы создаются заранее: потоки пишут только в свой элемент
+        QList<QList<qsizetype>> partial(chunkCount);
+        QList<qsizetype>* results = partial.data();
+        auto scanChunk = [&slotAt, &test, results, chunkSize, count](qsizetype chunk) {
+            const qsizetype end = std::min(count, (chunk + 1) * chunkSize);
+            for (qsizetype i = chunk * chunkSize; i < end; ++i) {
+                const qsizetype slot = slotAt(i);
+                if (test(slot)) {
+                    results[chunk].append(slot);
+                }
+            }
+        };
+
+        ParallelFor::run(chunkCount, scanChunk);
+
+        if (chunkCount == 1) {
+            return partial.first();
+        }
+        qsizetype total = 0;
+        for (const QList<qsizetype>& part : partial) {
+            total += part.size();
+        }
+        QList<qsizetype> selected;
+        selected.reserve(total);
+        for (const QList<qsizetype>& part : partial) {
+            selected.append(part);
+        }
+        return selected;
+    }
+
+    // Множество id треков, удовлетворяющих условию с битовым индексом
+    RoaringBitmap predicateBitmap(const TrackRepository& repository, const FilterContext& context,
+                                  PredicateKind kind) {
+        switch (kind) {
+        case PredicateKind::Year:
+            return repository.yearRangeIndex().bitmap(context.years.min, context.years.max);
+        case PredicateKind::Duration:
+            return repository.durationRangeIndex().bitmap(context.durations.min, context.durations.max);
+        case PredicateKind::Source:
+            return repository.sourceBitmap(context.source);
+        default:
+            break;
+        }
+        RoaringBitmap result;
+        for (qsizetype code = 0; code < context.genreMatches.size(); ++code) {
+            if (context.genreMatches.at(code)) {
+                result |= repository.genreBitmap(static_cast<quint32>(code));
+            }
+        }
+        return result;
+    }
+
+    FilterContext makeContext(const TrackColumns& columns, const TrackSearchParams& params) {
+        return FilterContext{columns, yearRange(params), durationRange(params),
+                             columns.artistPool().matchingCodes(TextFolding::fold(params.artist)),
+                             columns.albumPool().matchingCodes(TextFolding::fold(params.album)),
+                             columns.genrePool().matchingCodes(TextFolding::fold(params.genre)),
+                             TextFolding::fold(params.title), params.source};
+    }
+
+    double fractionOf(qsizetype count, qsizetype rows) {
+        return rows == 0 ? 0.0 : static_cast<double>(count) / rows;
+    }
+
+    // Условия с оценкой селективности. Пустые условия пропускают все строки
+    // и в план не попадают. Доли строк для года, длительности, источника и
+    // словарных колонок считаются точно по индексам и статистике, для
+    // названия - по выборке.
+    QList<Predicate> estimatePredicates(const TrackRepository& repository, const TrackSearchParams& params,
+                                        const FilterContext& context) {
+        const TrackColumns& columns = context.columns;
+        const qsizetype rows = columns.size();
+        const RangeIndex& yearIndex = repository.yearRangeIndex();
+        const RangeIndex& durationIndex = repository.durationRangeIndex();
+        QList<Predicate> predicates;
+        if (!context.years.isUnbounded()) {
+            predicates.append({PredicateKind::Year, rangeDetail("year", context.years),
+                               fractionOf(yearIndex.count(context.years.min, context.years.max), rows),
+                               RANGE_COST});
+        }
+        if (!context.durations.isUnbounded()) {
+            predicates.append({PredicateKind::Duration, rangeDetail("duration", context.durations),
+                               fractionOf(durationIndex.count(context.durations.min, context.durations.max), rows),
+                               RANGE_COST});
+        }
+        if (params.source != TrackSource::Any) {
+            predicates.append({PredicateKind::Source,
+                               params.source == TrackSource::YandexMusic ? "source = yandex" : "source = local",
+                               fractionOf(repository.sourceBitmap(params.source).cardinality(), rows),
+                               RANGE_COST});
+        }
+        if (!params.artist.isEmpty()) {
+            predicates.append({PredicateKind::Artist, QString("artist ~ \"%1\"").arg(params.artist),
+                               codeSelectivity(context.artistMatches, columns.artistUsage(), rows), CODE_COST});
+        }
+        if (!params.album.isEmpty()) {
+            predicates.append({PredicateKind::Album, QString("album ~ \"%1\"").arg(params.album),
+                               codeSelectivity(context.albumMatches, columns.albumUsage(), rows), CODE_COST});
+        }
+        if (!params.genre.isEmpty()) {
+            predicates.append({PredicateKind::Genre, QString("genre ~ \"%1\"").arg(params.genre),
+                               codeSelectivity(context.genreMatches, columns.genreUsage(), rows), CODE_COST});
+        }
+        if (!context.foldedTitle.isEmpty()) {
+            const double selectivity = withTest(context, PredicateKind::Title, [rows](auto test) {
+                return sampledSelectivity(rows, test);
+            });
+            predicates.append({PredicateKind::Title, QString("title ~ \"%1\"").arg(params.title),
+                               selectivity, TITLE_COST});
+        }
+        return predicates;
+    }
+
+    // Конец шага плана, начинающегося с predicates[from]: подряд идущие
+    // дешевые условия объединяются в один шаг (если fused), название
+    // проверяется отдельно
+    qsizetype stepEnd(const QList<Predicate>& predicates, qsizetype from, bool fused) {
+        qsizetype end = from + 1;
+        if (!fused || predicateBit(predicates.at(from).kind) == 0) {
+            return end;
+        }
+        while (end < predicates.size() && predicateBit(predicates.at(end).kind) != 0) {
+            ++end;
+        }
+        return end;
+    }
+
+    // Отобрать позиции slotAt(0..count), прошедшие условия predicates[from, end)
+    template<typename SlotAt>
+    QList<qsizetype> selectStep(const FilterContext& context, const QList<Predicate>& predicates,
+                                qsizetype from, qsizetype end, qsizetype count, SlotAt slotAt,
+                                qsizetype parallelThreshold) {
+        auto select = [count, &slotAt, parallelThreshold](auto test) {
+            return selectSlots(count, slotAt, test, parallelThreshold);
+        };
+        if (end - from == 1) {
+            return withTest(context, predicates.at(from).kind, select);
+        }
+        // Условия шага проверяются в порядке ранга. Если он совпадает с
+        // порядком битов, подходит FusedTest<Mask> без переходов по видам
+        // условий, иначе — RankedFusedTest.
+        unsigned mask = 0;
+        bool bitOrder = true;
+        RankedFusedTest ranked{nullptr, {}, 0};
+        for (qsizetype i = from; i < end; ++i) {
+            const unsigned bit = predicateBit(predicates.at(i).kind);
+            bitOrder = bitOrder && bit > mask;
+            mask |= bit;
+            ranked.kinds[ranked.count++] = predicates.at(i).kind;
+        }
+        const FusedColumns fused = fusedColumns(context);
+        if (bitOrder) {
+            return withFusedTest(fused, mask, select);
+        }
+        ranked.fused = &fused;
+        return select(ranked);
+    }
+
+    // Описание и оценка селективности шага из условий predicates[from, end)
+    QString stepDetail(const QList<Predicate>& predicates, qsizetype from, qsizetype end) {
+        QStringList details;
+        for (qsizetype i = from; i < end; ++i) {
+            details.append(predicates.at(i).detail);
+        }
+        return details.join(" & ");
+    }
+
+    double stepSelectivity(const QList<Predicate>& predicates, qsizetype from, qsizetype end) {
+        double selectivity = 1.0;
+        for (qsizetype i = from; i < end; ++i) {
+            selectivity *= predicates.at(i).selectivity;
+        }
+        return selectivity;
+    }
+
+    // Сузить список позиций условиями predicates[from..] по шагам
+    void narrowSlots(const FilterContext& context, const QList<Predicate>& predicates, qsizetype from,
+                     bool fused, QList<qsizetype>& slots, qsizetype parallelThreshold, SearchPlan* plan) {
+        QElapsedTimer timer;
+        for (qsizetype next = from; next < predicates.size() && !slots.isEmpty();) {
+            const qsizetype end = stepEnd(predicates, next, fused);
+            timer.start();
+            const qsizetype input = slots.size();
+            const qsizetype* data = slots.constData();
+            slots = selectStep(context, predicates, next, end, input, [data](qsizetype i) { return data[i]; },
+                               parallelThreshold);
+            if (plan) {
+                plan->steps.append({end - next > 1 ? "fused filter" : "filter", stepDetail(predicates, next, end),
+                                    stepSelectivity(predicates, next, end), input, slots.size(),
+                                    timer.nsecsElapsed()});
+            }
+            next = end;
+        }
+    }
+
+    // Стоимость цепочки проверок, начиная с rows строк
+    double chainCost(const QList<Predicate>& predicates, double rows) {
+        double cost = 0.0;
+        for (const Predicate& predicate : predicates) {
+            cost += rows * predicate.cost;
+            rows *= predicate.selectivity;
+        }
+        return cost;
+    }
+
+    void orderByRank(QList<Predicate>& predicates) {
+        std::stable_sort(predicates.begin(), predicates.end(), [](const Predicate& a, const Predicate& b) {
+            return a.rank() < b.rank();
+        });
+    }
+}
+
+FilterPlanner::FilterPlanner(const TrackRepository& repository)
+    : repository(repository)
+{
+}
+
+QList<qsizetype> FilterPlanner::execute(const TrackSearchParams& params, qsizetype parallelThreshold,
+                                        SearchPlan* plan) const {
+    const TrackColumns& columns = repository.trackColumns();
+    const qsizetype rows = columns.size();
+    const FilterContext context = makeContext(columns, params);
+    QList<Predicate> predicates = estimatePredicates(repository, params, context);
+    auto fraction = [rows](qsizetype count) { return fractionOf(count, rows); };
+
+    // Выбор пути доступа: полный проход или кандидаты из индекса.
+    // Битовые индексы точны, поэтому их условия дальше не проверяются;
+    // триграммы дают надмножество, и название проверяется среди кандидатов.
+    AccessPath path = AccessPath::FullScan;
+    double inputRows = rows;
+    orderByRank(predicates);
+    double bestCost = chainCost(predicates, rows);
+    auto consider = [&](AccessPath candidate, double candidateRows, double accessCost,
+                        QList<Predicate> remaining) {
+        orderByRank(remaining);
+        const double cost = accessCost + candidateRows * INDEX_ROW_COST + chainCost(remaining, candidateRows);
+        if (cost >= bestCost) {
+            return false;
+        }
+        path = candidate;
+        inputRows = candidateRows;
+        bestCost = cost;
+        predicates = remaining;
+        return true;
+    };
+    const QList<Predicate> all = predicates;
+
+    // Битовый путь: пересечение самых селективных условий с битовыми индексами.
+    // Перебираются префиксы списка, упорядоченного по селективности.
+    QList<Predicate> bitmapPredicates;
+    std::copy_if(all.cbegin(), all.cend(), std::back_inserter(bitmapPredicates),
+                 [](const Predicate& predicate) { return hasBitmap(predicate.kind); });
+    std::stable_sort(bitmapPredicates.begin(), bitmapPredicates.end(),
+                     [](const Predicate& a, const Predicate& b) { return a.selectivity < b.selectivity; });
+    qsizetype bitmapPrefix = 0;
+    double bitmapRows = rows;
+    double bitmapCost = 0.0;
+    QList<Predicate> remaining = all;
+    for (qsizetype used = 0; used < bitmapPredicates.size(); ++used) {
+        const Predicate& added = bitmapPredicates.at(used);
+        bitmapRows *= added.selectivity;
+        bitmapCost += rows * added.selectivity * BITMAP_ROW_COST;
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&added](const Predicate& other) {
+            return other.kind == added.kind;
+        }), remaining.end());
+        if (consider(AccessPath::BitmapIndex, bitmapRows, bitmapCost, remaining)) {
+            bitmapPrefix = used + 1;
+        }
+    }
+
+    qsizetype trigramRows = 0;
+    if (!context.foldedTitle.isEmpty() &&
+        repository.titleTrigrams().estimate(context.foldedTitle, trigramRows)) {
+        // Среди кандидатов доля совпадений по названию выше, чем по всему каталогу
+        QList<Predicate> withTitle = all;
+        for (Predicate& predicate : withTitle) {
+            if (predicate.kind == PredicateKind::Title) {
+                predicate.selectivity = trigramRows == 0
+                    ? 0.0
+                    : std::min(1.0, predicate.selectivity * rows / trigramRows);
+            }
+        }
+        consider(AccessPath::TrigramIndex, trigramRows, 0.0, withTitle);
+    }
+
+    double estimatedRows = inputRows;
+    for (const Predicate& predicate : predicates) {
+        estimatedRows *= predicate.selectivity;
+    }
+    if (plan) {
+        plan->accessPath = accessPathName(path);
+        plan->estimatedCost = bestCost;
+        plan->estimatedRows = static_cast<qsizetype>(estimatedRows + 0.5);
+        plan->steps.clear();
+    }
+
+    QElapsedTimer timer;
+    auto record = [plan, &timer](const QString& operation, const QString& detail,
+                                 double selectivity, qsizetype input, qsizetype output) {
+        if (plan) {
+            plan->steps.append({operation, detail, selectivity, input, output, timer.nsecsElapsed()});
+        }
+    };
+
+    // Первый шаг дает начальный список позиций
+    timer.start();
+    QList<qsizetype> slots;
+    qsizetype next = 0;
+    switch (path) {
+    case AccessPath::TrigramIndex:
+        repository.titleCandidateSlots(context.foldedTitle, slots);
+        record("trigram", QString("title ~ \"%1\"").arg(params.title), fraction(trigramRows),
+               rows, slots.size());
+        break;
+    case AccessPath::BitmapIndex: {
+        RoaringBitmap matched = predicateBitmap(repository, context, bitmapPredicates.first().kind);
+        QStringList details{bitmapPredicates.first().detail};
+        for (qsizetype i = 1; i < bitmapPrefix; ++i) {
+            matched &= predicateBitmap(repository, context, bitmapPredicates.at(i).kind);
+            details.append(bitmapPredicates.at(i).detail);
+        }
+        slots = repository.slotsOf(matched.toList());
+        record("bitmap", details.join(" & "), fraction(slots.size()), rows, slots.size());
+        break;
+    }
+    case AccessPath::FullScan:
+        if (predicates.isEmpty()) {
+            slots.resize(rows);
+            std::iota(slots.begin(), slots.end(), qsizetype(0));
+            record("scan", QString(), 1.0, rows, rows);
+            break;
+        }
+        // Проход по колонкам сразу проверяет все дешевые условия первого шага
+        next = stepEnd(predicates, 0, fusedSteps);
+        slots = selectStep(context, predicates, 0, next, rows, [](qsizetype i) { return i; },
+                           parallelThreshold);
+        record("scan", stepDetail(predicates, 0, next), stepSelectivity(predicates, 0, next),
+               rows, slots.size());
+        break;
+    }
+
+    // Остальные условия сужают список по одному
+    narrowSlots(context, predicates, next, fusedSteps, slots, parallelThreshold, plan);
+    return slots;
+}
+
+QList<qsizetype> FilterPlanner::refine(const TrackSearchParams& params, const TrackSearchParams& previous,
+                                       const QList<qsizetype>& candidates, qsizetype parallelThreshold) const {
+    const FilterContext context = makeContext(repository.trackColumns(), params);
+    QList<Predicate> predicates = estimatePredicates(repository, params, context);
+
+    // Условия, не изменившиеся с прошлого запроса, кандидаты уже выполняют
+    const FilterContext before = makeContext(repository.trackColumns(), previous);
+    predicates.erase(std::remove_if(predicates.begin(), predicates.end(), [&](const Predicate& predicate) {
+        switch (predicate.kind) {
+        case PredicateKind::Year:
+            return context.years.min == before.years.min && context.years.max == before.years.max;
+        case PredicateKind::Duration:
+            return context.durations.min == before.durations.min && context.durations.max == before.durations.max;
+        case PredicateKind::Source:
+            return params.source == previous.source;
+        case PredicateKind::Artist:
+            return params.artist == previous.artist;
+        case PredicateKind::Album:
+            return params.album == previous.album;
+        case PredicateKind::Genre:
+            return params.genre == previous.genre;
+        case PredicateKind::Title:
+            return context.foldedTitle == before.foldedTitle;
+        }
+        return false;
+    }), predicates.end());
+    orderByRank(predicates);
+
+    QList<qsizetype> slots = candidates;
+    narrowSlots(context, predicates, 0, fusedSteps, slots, parallelThreshold, nullptr);
+    return slots;
+}
+
+bool FilterPlanner::narrows(const TrackSearchParams& narrower, const TrackSearchParams& wider) {
+    auto within = [](const IntRange& inner, const IntRange& outer) {
+        return inner.min >= outer.min && inner.max <= outer.max;
+    };
+    // Строка, содержащая более длинный образец, содержит и его часть
+    auto extends = [](const QString& longer, const QString& shorter) {
+        return TextFolding::fold(longer).contains(TextFolding::fold(shorter));
+    };
+    return extends(narrower.title, wider.title) && extends(narrower.artist, wider.artist) &&
+           extends(narrower.album, wider.album) && extends(narrower.genre, wider.genre) &&
+           within(yearRange(narrower), yearRange(wider)) &&
+           within(durationRange(narrower), durationRange(wider)) &&
+           (wider.source == TrackSource::Any || wider.source == narrower.source);
+}
+
+QString FilterPlanner::canonicalKey(const TrackSearchParams& params) {
+    const IntRange years = yearRange(params);
+    const IntRange durations = durationRange(params);
+    auto bound = [](int value, int unbounded) {
+        return value == unbounded ? QString() : QString::number(value);
+    };
+    const QStringList parts{TextFolding::fold(params.title), TextFolding::fold(params.artist),
+                            TextFolding::fold(params.album), TextFolding::fold(params.genre),
+                            bound(years.min, INT_MIN), bound(years.max, INT_MAX),
+                            bound(durations.min, INT_MIN), bound(durations.max, INT_MAX),
+                            QString::number(static_cast<int>(params.source))};
+    // Разделитель, который не встречается в названиях
+    return parts.join(QChar(0x1F));
+}
@@ -0,0 +1,210 @@
+// FuzzyIndex.cpp
+#include "core/FuzzyIndex.h"
+#include "core/TextFolding.h"
+#include <QtGlobal>
+#include <algorithm>
+
+namespace {
+    // Длина слова, для которой строки матрицы расстояния помещаются на стеке
+    constexpr qsizetype STACK_WORD_LENGTH = 63;
+    // Дерево не перестраивается, пока в нем меньше узлов
+    constexpr qsizetype MIN_REBUILD_NODES = 64;
+
+    // Сколько правок допустимо для слова запроса такой длины
+    int allowedDistance(qsizetype length, int maxDistance) {
+        if (length < 3) {
+            return 0;
+        }
+        if (length < 6) {
+            return qMin(1, maxDistance);
+        }
+        return maxDistance;
+    }
+}
+
+QStringList FuzzyIndex::tokensOf(const QString& foldedText) {
+    QStringList tokens = TextFolding::words(foldedText);
+    tokens.removeDuplicates();
+    return tokens;
+}
+
+int FuzzyIndex::distance(const QString& a, const QString& b) {
+    // Строки матрицы идут по более короткому слову
+    if (b.size() > a.size()) {
+        return distance(b, a);
+    }
+    // Две строки матрицы динамического программирования; для обычных слов
+    // они на стеке, память выделяется только для очень длинных
+    int stackRows[2][STACK_WORD_LENGTH + 1];
+    QList<int> heapRows;
+    int* previous = stackRows[0];
+    int* current = stackRows[1];
+    if (b.size() > STACK_WORD_LENGTH) {
+        heapRows.resize(2 * (b.size() + 1));
+        previous = heapRows.data();
+        current = previous + b.size() + 1;
+    }
+    for (qsizetype j = 0; j <= b.size(); ++j) {
+        previous[j] = static_cast<int>(j);
+    }
+    for (qsizetype i = 1; i <= a.size(); ++i) {
+        current[0] = static_cast<int>(i);
+        const QChar left = a.at(i - 1);
+        for (qsizetype j = 1; j <= b.size(); ++j) {
+            const int substitution = previous[j - 1] + (left == b.at(j - 1) ? 0 : 1);
+            current[j] = qMin(substitution, qMin(previous[j], current[j - 1]) + 1);
+        }
+        std::swap(previous, current);
+    }
+    return previous[b.size()];
+}
+
+qsizetype FuzzyIndex::nodeFor(const QString& token) {
+    if (const auto it = nodeIndex.constFind(token); it != nodeIndex.constEnd()) {
+        return it.value();
+    }
+    Node node;
+    node.token = token;
+    nodes.append(node);
+    const qsizetype added = nodes.size() - 1;
+    nodeIndex.insert(token, added);
+    // Ключ в новый узел добавляет вызывающий
+    ++emptyNodes;
+    if (added == 0) {
+        return added;
+    }
+
+    // Спуск от корня по ребру с расстоянием до нового слова
+    qsizetype current = 0;
+    for (;;) {
+        const int d = distance(token, nodes.at(current).token);
+        const QList<QPair<int, qsizetype>>& children = nodes.at(current).children;
+        const auto child = std::find_if(children.cbegin(), children.cend(),
+                                        [d](const QPair<int, qsizetype>& edge) { return edge.first == d; });
+        if (child == children.cend()) {
+            nodes[current].children.append(qMakePair(d, added));
+            return added;
+        }
+        current = child->second;
+    }
+}
+
+void FuzzyIndex::insert(int key, const QString& foldedText) {
+    for (const QString& token : tokensOf(foldedText)) {
+        QList<int>& keys = nodes[nodeFor(token)].keys;
+        if (keys.isEmpty()) {
+            --emptyNodes;
+        }
+        // Новые треки обычно получают наибольший id: добавление в конец за O(1)
+        if (keys.isEmpty() || keys.last() < key) {
+            keys.append(key);
+            continue;
+        }
+        const auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        if (*it != key) {
+            keys.insert(it, key);
+        }
+    }
+}
+
+void FuzzyIndex::remove(int key, const QString& foldedText) {
+    for (const QString& token : tokensOf(foldedText)) {
+        const qsizetype node = nodeIndex.value(token, -1);
+        if (node < 0) {
+            continue;
+        }
+        QList<int>& keys = nodes[node].keys;
+        const auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        if (it != keys.end() && *it == key) {
+            keys.erase(it);
+            if (keys.isEmpty()) {
+                ++emptyNodes;
+            }
+        }
+    }
+    // Пустые узлы замедляют каждый поиск: перестраиваем, пока их не больше четверти
+    if (nodes.size() >= MIN_REBUILD_NODES && emptyNodes * 4 > nodes.size()) {
+        rebuild();
+    }
+}
+
+void FuzzyIndex::clear() {
+    nodes.clear();
+    nodeIndex.clear();
+    emptyNodes = 0;
+}
+
+void FuzzyIndex::rebuild() {
+    QList<Node> live;
+    live.reserve(nodes.size() - emptyNodes);
+    for (Node& node : nodes) {
+        if (!node.keys.isEmpty()) {
+            live.append(std::move(node));
+        }
+    }
+    clear();
+    for (Node& node : live) {
+        nodes[nodeFor(node.token)].keys = std::move(node.keys);
+        --emptyNodes;
+    }
+}
+
+QHash<int, int> FuzzyIndex::nearestKeys(const QString& token, int limit) const {
+    QHash<int, int> nearest;
+    if (nodes.isEmpty()) {
+        return nearest;
+    }
+    QList<qsizetype> pending{0};
+    while (!pending.isEmpty()) {
+        const Node& node = nodes.at(pending.takeLast());
+        const int d = distance(token, node.token);
+        if (d <= limit) {
+            for (int key : node.keys) {
+                const auto it = nearest.find(key);
+                if (it == nearest.end()) {
+                    nearest.insert(key, d);
+                } else if (d < it.value()) {
+                    it.value() = d;
+                }
+            }
+        }
+        for (const QPair<int, qsizetype>& edge : node.children) {
+            if (edge.first >= d - limit && edge.first <= d + limit) {
+                pending.append(edge.second);
+            }
+        }
+    }
+    return nearest;
+}
+
+QList<FuzzyIndex::Match> FuzzyIndex::search(const QString& foldedQuery, int maxDistance) const {
+    QList<Match> matches;
+    const QStringList tokens = tokensOf(foldedQuery);
+    if (tokens.isEmpty()) {
+        return matches;
+    }
+
+    // Документ должен подойти к каждому слову запроса; расстояния суммируются
+    QHash<int, int> total = nearestKeys(tokens.first(), allowedDistance(tokens.first().size(), maxDistance));
+    for (qsizetype i = 1; i < tokens.size() && !total.isEmpty(); ++i) {
+        const QHash<int, int> nearest = nearestKeys(tokens.at(i), allowedDistance(tokens.at(i).size(), maxDistance));
+        for (auto it = total.begin(); it != total.end();) {
+            const auto found = nearest.constFind(it.key());
+            if (found == nearest.constEnd()) {
+                it = total.erase(it);
+            } else {
+                it.value() += found.value();
+                ++it;
+            }
+        }
+    }
+
+    matches.reserve(total.size());
+    for (auto it = total.cbegin(); it != total.cend(); ++it) {
+        matches.append({it.key(), it.value()});
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.key < b.key;
+    });
+    return matches;
+}
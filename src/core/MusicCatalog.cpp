@@ -1,5 +1,6 @@
 // MusicCatalog.cpp
 #include "core/MusicCatalog.h"
+#include "core/TextFolding.h"
 
 MusicCatalog::MusicCatalog()
     : searcher(repository), sorter(repository)
@@ -36,10 +37,6 @@ bool MusicCatalog::updateTrack(int id, const Track& updatedTrack) {
     return repository.updateTrack(id, updatedTrack);
 }
 
-Track* MusicCatalog::findTrackById(int id) {
-    return repository.findTrackById(id);
-}
-
 const Track* MusicCatalog::findTrackById(int id) const {
     return repository.findTrackById(id);
 }
@@ -48,6 +45,10 @@ QList<Track> MusicCatalog::findAllTracks() const {
     return repository.findAllTracks();
 }
 
+TrackView MusicCatalog::tracksView() const {
+    return repository.tracksView();
+}
+
 QList<Track> MusicCatalog::findTracksByTitle(const QString& title) const {
     return searcher.findTracksByTitle(title);
 }
@@ -69,11 +70,96 @@ QList<Track> MusicCatalog::findTracksByYearRange(int startYear, int endYear) con
 }
 
 QList<Track> MusicCatalog::searchTracks(const QString& searchTerm) const {
-    return searcher.searchTracks(searchTerm);
+    return tracksWithIds(searchTrackIds(searchTerm));
 }
 
 QList<Track> MusicCatalog::searchTracksWithFilters(const TrackSearchParams& params) const {
-    return searcher.searchTracksWithFilters(params);
+    return tracksWithIds(searchTrackIdsWithFilters(params));
+}
+
+QList<Track> MusicCatalog::searchTracksByQuery(const QString& query) const {
+    return tracksWithIds(searchTrackIdsByQuery(query));
+}
+
+QList<int> MusicCatalog::searchTrackIdsByQuery(const QString& query, const ResultWindow& window) const {
+    const TrackQuery parsed = TrackQuery::parse(query);
+    return cachedSearch("query:" + parsed.toString(), window,
+                        [&] { return searcher.querySlots(parsed); });
+}
+
+QList<Track> MusicCatalog::searchTracksRanked(const QString& query, qsizetype limit) const {
+    return searcher.rankedSearch(query, limit);
+}
+
+QList<Track> MusicCatalog::fuzzySearchTracks(const QString& query, int maxDistance) const {
+    return searcher.fuzzySearch(query, maxDistance);
+}
+
+QList<int> MusicCatalog::searchTrackIds(const QString& searchTerm, const ResultWindow& window) const {
+    return cachedSearch("term:" + TextFolding::fold(searchTerm), window,
+                        [&] { return searcher.searchSlots(searchTerm); });
+}
+
+QList<int> MusicCatalog::searchTrackIdsWithFilters(const TrackSearchParams& params,
+                                                   const ResultWindow& window) const {
+    return cachedSearch("filter:" + FilterPlanner::canonicalKey(params), window,
+                        [&] { return searcher.searchSlotsWithFilters(params); });
+}
+
+template<typename Search>
+QList<int> MusicCatalog::cachedSearch(const QString& key, const ResultWindow& window, Search search) const {
+    // В кэше лежит полный результат в порядке каталога, окно вырезается из него
+    QList<int> ids;
+    QList<qsizetype> slots;
+    if (queryCache.lookup(key, repository.getGeneration(), ids)) {
+        slots = repository.slotsOf(ids);
+    } else {
+        slots = search();
+        queryCache.insert(key, repository.getGeneration(), searcher.pageIds(slots, ResultWindow()));
+    }
+    return searcher.pageIds(slots, window);
+}
+
+void MusicCatalog::setQueryCacheBudget(qsizetype budgetBytes) {
+    queryCache.setBudget(budgetBytes);
+}
+
+QueryCache::Stats MusicCatalog::queryCacheStats() const {
+    return queryCache.stats();
+}
+
+QList<Track> MusicCatalog::tracksWithIds(const QList<int>& ids) const {
+    QList<Track> result;
+    result.reserve(ids.size());
+    for (int id : ids) {
+        result.append(*repository.findTrackById(id));
+    }
+    return result;
+}
+
+SearchPlan MusicCatalog::explainSearch(const TrackSearchParams& params) const {
+    return searcher.explain(params);
+}
+
+SearchSession MusicCatalog::startSearchSession() const {
+    return searcher.startSession();
+}
+
+void MusicCatalog::setParallelSearchThreshold(qsizetype threshold) {
+    searcher.setParallelThreshold(threshold);
+}
+
+QList<int> MusicCatalog::trackIdsInOrder(const ResultWindow& window) const {
+    return repository.orderedIds(window);
+}
+
+QList<int> MusicCatalog::topTrackIds(const QList<SortKey>& spec, qsizetype count) const {
+    return searcher.topIds(spec, count);
+}
+
+QList<int> MusicCatalog::topTrackIds(const TrackSearchParams& params, const QList<SortKey>& spec,
+                                     qsizetype count) const {
+    return searcher.topIds(searcher.searchSlotsWithFilters(params), spec, count);
 }
 
 void MusicCatalog::sortByTitle(bool ascending) {
@@ -92,10 +178,44 @@ void MusicCatalog::sortByDuration(bool ascending) {
     sorter.sortByDuration(ascending);
 }
 
+void MusicCatalog::sortBy(const QList<SortKey>& spec) {
+    sorter.sortBy(spec);
+}
+
+void MusicCatalog::setParallelSortThreshold(qsizetype threshold) {
+    sorter.setParallelThreshold(threshold);
+}
+
 int MusicCatalog::getTrackCount() const {
     return repository.getTrackCount();
 }
 
+QMap<QString, qsizetype> MusicCatalog::countTracksByGenre() const {
+    QMap<QString, qsizetype> counts;
+    const StringPool& genres = repository.trackColumns().genrePool();
+    for (quint32 code = 0; code < static_cast<quint32>(genres.size()); ++code) {
+        if (const qsizetype count = repository.genreBitmap(code).cardinality(); count > 0) {
+            counts.insert(genres.value(code), count);
+        }
+    }
+    return counts;
+}
+
+QMap<int, qsizetype> MusicCatalog::countTracksByYear() const {
+    return repository.yearRangeIndex().counts();
+}
+
+qsizetype MusicCatalog::countTracksBySource(TrackSource source) const {
+    if (source == TrackSource::Any) {
+        return repository.getTrackCount();
+    }
+    return repository.sourceBitmap(source).cardinality();
+}
+
+quint64 MusicCatalog::getGeneration() const {
+    return repository.getGeneration();
+}
+
 int MusicCatalog::getNextId() const {
     return repository.getNextId();
 }
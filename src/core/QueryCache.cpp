@@ -0,0 +1,60 @@
+// QueryCache.cpp
+#include "core/QueryCache.h"
+
+namespace {
+    // Приблизительный объем записи: ключ, список id и служебные данные узла
+    constexpr qsizetype ENTRY_OVERHEAD = 64;
+
+    qsizetype entryCost(const QString& key, const QList<int>& ids) {
+        return ENTRY_OVERHEAD + key.size() * qsizetype(sizeof(QChar)) + ids.size() * qsizetype(sizeof(int));
+    }
+}
+
+QueryCache::QueryCache(qsizetype budgetBytes)
+    : entries(budgetBytes)
+{
+}
+
+void QueryCache::syncGeneration(quint64 current) {
+    if (current != generation) {
+        entries.clear();
+        generation = current;
+    }
+}
+
+bool QueryCache::lookup(const QString& key, quint64 currentGeneration, QList<int>& ids) {
+    syncGeneration(currentGeneration);
+    if (const QList<int>* cached = entries.object(key)) {
+        ++hits;
+        ids = *cached;
+        return true;
+    }
+    ++misses;
+    return false;
+}
+
+void QueryCache::insert(const QString& key, quint64 currentGeneration, const QList<int>& ids) {
+    syncGeneration(currentGeneration);
+    // Результат больше бюджета QCache не примет и сам освободит
+    entries.insert(key, new QList<int>(ids), entryCost(key, ids));
+}
+
+void QueryCache::setBudget(qsizetype budgetBytes) {
+    entries.setMaxCost(budgetBytes);
+}
+
+void QueryCache::clear() {
+    entries.clear();
+    hits = 0;
+    misses = 0;
+}
+
+QueryCache::Stats QueryCache::stats() const {
+    Stats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.entries = entries.size();
+    result.bytes = entries.totalCost();
+    result.budget = entries.maxCost();
+    return result;
+}
@@ -0,0 +1,45 @@
+// RangeIndex.cpp
+#include "core/RangeIndex.h"
+
+void RangeIndex::insert(int key, int id) {
+    buckets[key].add(static_cast<quint32>(id));
+}
+
+void RangeIndex::remove(int key, int id) {
+    const auto found = buckets.find(key);
+    if (found == buckets.end()) {
+        return;
+    }
+    found.value().remove(static_cast<quint32>(id));
+    if (found.value().isEmpty()) {
+        buckets.erase(found);
+    }
+}
+
+void RangeIndex::clear() {
+    buckets.clear();
+}
+
+qsizetype RangeIndex::count(int min, int max) const {
+    qsizetype total = 0;
+    for (auto it = buckets.lowerBound(min); it != buckets.cend() && it.key() <= max; ++it) {
+        total += it.value().cardinality();
+    }
+    return total;
+}
+
+QMap<int, qsizetype> RangeIndex::counts() const {
+    QMap<int, qsizetype> result;
+    for (auto it = buckets.cbegin(); it != buckets.cend(); ++it) {
+        result.insert(it.key(), it.value().cardinality());
+    }
+    return result;
+}
+
+RoaringBitmap RangeIndex::bitmap(int min, int max) const {
+    RoaringBitmap result;
+    for (auto it = buckets.lowerBound(min); it != buckets.cend() && it.key() <= max; ++it) {
+        result |= it.value();
+    }
+    return result;
+}
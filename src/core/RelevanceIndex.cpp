@@ -0,0 +1,187 @@
+// RelevanceIndex.cpp
+#include "core/RelevanceIndex.h"
+#include "core/TextFolding.h"
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Лучший результат раньше: больше оценка, при равенстве меньше ключ
+    bool ranksBefore(const RelevanceIndex::Hit& a, const RelevanceIndex::Hit& b) {
+        return a.score != b.score ? a.score > b.score : a.key < b.key;
+    }
+}
+
+void RelevanceIndex::insert(int key, const std::array<QString, FIELD_COUNT>& foldedFields) {
+    remove(key);
+    QList<QStringList> fields;
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        const QStringList words = TextFolding::words(foldedFields[field]);
+        for (const QString& word : words) {
+            FieldCounts& counts = postings[word][key];
+            ++counts[field];
+        }
+        totalLengths[field] += words.size();
+        fields.append(words);
+    }
+    documents.insert(key, fields);
+    invalidate(fields);
+    updateNormalization();
+}
+
+void RelevanceIndex::remove(int key) {
+    const auto document = documents.constFind(key);
+    if (document == documents.constEnd()) {
+        return;
+    }
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        const QStringList& words = document.value().at(field);
+        for (const QString& word : words) {
+            const auto term = postings.find(word);
+            if (term == postings.end()) {
+                continue;
+            }
+            term.value().remove(key);
+            if (term.value().isEmpty()) {
+                postings.erase(term);
+            }
+        }
+        totalLengths[field] -= words.size();
+    }
+    invalidate(document.value());
+    documents.erase(document);
+    updateNormalization();
+}
+
+void RelevanceIndex::clear() {
+    postings.clear();
+    documents.clear();
+    totalLengths = {};
+    averageLengths = {};
+    ++normalizationVersion;
+    impactCache.clear();
+}
+
+void RelevanceIndex::invalidate(const QList<QStringList>& fields) {
+    for (const QStringList& words : fields) {
+        for (const QString& word : words) {
+            impactCache.remove(word);
+        }
+    }
+}
+
+void RelevanceIndex::updateNormalization() {
+    const double documentCount = documents.size();
+    bool drifted = false;
+    std::array<double, FIELD_COUNT> current;
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        current[field] = documentCount > 0 ? qMax(1.0, totalLengths[field] / documentCount) : 1.0;
+        drifted = drifted ||
+                  std::fabs(current[field] - averageLengths[field]) > NORMALIZATION_TOLERANCE * averageLengths[field];
+    }
+    if (drifted) {
+        averageLengths = current;
+        ++normalizationVersion;
+    }
+}
+
+void RelevanceIndex::cacheImpacts(const QString& term) const {
+    const auto found = postings.constFind(term);
+    if (found == postings.constEnd()) {
+        return;
+    }
+    const auto cached = impactCache.constFind(term);
+    if (cached != impactCache.constEnd() && cached.value().version == normalizationVersion) {
+        return;
+    }
+    Impacts impacts;
+    impacts.version = normalizationVersion;
+    impacts.ordered.reserve(found.value().size());
+    for (auto it = found.value().cbegin(); it != found.value().cend(); ++it) {
+        const QList<QStringList>& fields = documents.value(it.key());
+        double weighted = 0.0;
+        for (int field = 0; field < FIELD_COUNT; ++field) {
+            if (it.value()[field] == 0) {
+                continue;
+            }
+            const double norm = 1.0 - B + B * fields.at(field).size() / averageLengths[field];
+            weighted += FIELD_WEIGHTS[field] * it.value()[field] / norm;
+        }
+        const double impact = weighted * (K1 + 1.0) / (K1 + weighted);
+        impacts.ordered.append({it.key(), impact});
+        impacts.byKey.insert(it.key(), impact);
+    }
+    std::sort(impacts.ordered.begin(), impacts.ordered.end(), [](const Posting& a, const Posting& b) {
+        return a.impact != b.impact ? a.impact > b.impact : a.key < b.key;
+    });
+    impactCache.insert(term, impacts);
+}
+
+QList<RelevanceIndex::Hit> RelevanceIndex::search(const QString& foldedQuery, qsizetype limit) const {
+    QStringList terms = TextFolding::words(foldedQuery);
+    terms.removeDuplicates();
+    // Сначала кэш пополняется всеми словами: вставка в QHash может перенести
+    // элементы, поэтому указатели берутся только после нее
+    for (const QString& term : terms) {
+        cacheImpacts(term);
+    }
+    // Списки вкладов и idf их слов
+    QList<const Impacts*> lists;
+    QList<double> idfs;
+    const double documentCount = documents.size();
+    for (const QString& term : terms) {
+        const auto impacts = impactCache.constFind(term);
+        if (impacts != impactCache.constEnd() && !impacts.value().ordered.isEmpty()) {
+            const double frequency = postings.constFind(term).value().size();
+            lists.append(&impacts.value());
+            idfs.append(std::log(1.0 + (documentCount - frequency + 0.5) / (frequency + 0.5)));
+        }
+    }
+
+    QList<Hit> best; // куча: худший из лучших в вершине
+    if (limit == 0 || lists.isEmpty()) {
+        return best;
+    }
+    QSet<int> seen;
+    QList<qsizetype> positions(lists.size(), 0);
+    for (;;) {
+        // Порог: оценка любого еще не встреченного документа не больше суммы
+        // текущих вкладов всех списков
+        double threshold = 0.0;
+        qsizetype next = -1;
+        for (qsizetype i = 0; i < lists.size(); ++i) {
+            if (positions.at(i) == lists.at(i)->ordered.size()) {
+                continue;
+            }
+            const double impact = idfs.at(i) * lists.at(i)->ordered.at(positions.at(i)).impact;
+            threshold += impact;
+            if (next < 0 || impact > idfs.at(next) * lists.at(next)->ordered.at(positions.at(next)).impact) {
+                next = i;
+            }
+        }
+        if (next < 0 || (limit > 0 && best.size() == limit && best.first().score > threshold)) {
+            break;
+        }
+
+        const int key = lists.at(next)->ordered.at(positions[next]++).key;
+        if (seen.contains(key)) {
+            continue;
+        }
+        seen.insert(key);
+        // Полная оценка документа через доступ по ключу к остальным спискам
+        Hit hit{key, 0.0};
+        for (qsizetype i = 0; i < lists.size(); ++i) {
+            hit.score += idfs.at(i) * lists.at(i)->byKey.value(key, 0.0);
+        }
+        if (limit < 0 || best.size() < limit) {
+            best.append(hit);
+            std::push_heap(best.begin(), best.end(), ranksBefore);
+        } else if (ranksBefore(hit, best.first())) {
+            std::pop_heap(best.begin(), best.end(), ranksBefore);
+            best.last() = hit;
+            std::push_heap(best.begin(), best.end(), ranksBefore);
+        }
+    }
+    std::sort_heap(best.begin(), best.end(), ranksBefore);
+    return best;
+}
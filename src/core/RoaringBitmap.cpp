@@ -0,0 +1,253 @@
+// RoaringBitmap.cpp
+#include "core/RoaringBitmap.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    quint16 highBits(quint32 value) { return static_cast<quint16>(value >> 16); }
+    quint16 lowBits(quint32 value) { return static_cast<quint16>(value & 0xFFFFu); }
+}
+
+qsizetype RoaringBitmap::findBlock(quint16 key) const {
+    // Позиция первого блока с ключом не меньше key
+    const auto it = std::lower_bound(blocks.cbegin(), blocks.cend(), key,
+                                     [](const Block& block, quint16 value) { return block.key < value; });
+    return std::distance(blocks.cbegin(), it);
+}
+
+void RoaringBitmap::toDense(Block& block) {
+    block.bits = QList<quint64>(BITMAP_WORDS, 0);
+    for (quint16 low : block.values) {
+        block.bits[low >> 6] |= quint64(1) << (low & 63);
+    }
+    block.values.clear();
+}
+
+void RoaringBitmap::toSparseIfSmall(Block& block) {
+    if (!block.isDense() || block.count > ARRAY_LIMIT) {
+        return;
+    }
+    block.values.clear();
+    block.values.reserve(block.count);
+    for (qsizetype word = 0; word < BITMAP_WORDS; ++word) {
+        for (quint64 bits = block.bits.at(word); bits != 0; bits &= bits - 1) {
+            block.values.append(static_cast<quint16>(word * 64 + qCountTrailingZeroBits(bits)));
+        }
+    }
+    block.bits.clear();
+}
+
+void RoaringBitmap::add(quint32 value) {
+    const quint16 key = highBits(value);
+    const quint16 low = lowBits(value);
+    const qsizetype index = findBlock(key);
+    if (index == blocks.size() || blocks.at(index).key != key) {
+        Block block;
+        block.key = key;
+        block.count = 1;
+        block.values.append(low);
+        blocks.insert(index, block);
+        return;
+    }
+
+    Block& block = blocks[index];
+    if (block.isDense()) {
+        quint64& word = block.bits[low >> 6];
+        const quint64 mask = quint64(1) << (low & 63);
+        if ((word & mask) == 0) {
+            word |= mask;
+            ++block.count;
+        }
+        return;
+    }
+    // Id обычно растут: добавление в конец за O(1)
+    if (block.values.last() < low) {
+        block.values.append(low);
+    } else {
+        const auto it = std::lower_bound(block.values.begin(), block.values.end(), low);
+        if (*it == low) {
+            return;
+        }
+        block.values.insert(it, low);
+    }
+    if (++block.count > ARRAY_LIMIT) {
+        toDense(block);
+    }
+}
+
+void RoaringBitmap::remove(quint32 value) {
+    const quint16 key = highBits(value);
+    const quint16 low = lowBits(value);
+    const qsizetype index = findBlock(key);
+    if (index == blocks.size() || blocks.at(index).key != key) {
+        return;
+    }
+
+    Block& block = blocks[index];
+    if (block.isDense()) {
+        quint64& word = block.bits[low >> 6];
+        const quint64 mask = quint64(1) << (low & 63);
+        if ((word & mask) == 0) {
+            return;
+        }
+        word &= ~mask;
+        --block.count;
+        toSparseIfSmall(block);
+    } else {
+        const auto it = std::lower_bound(block.values.begin(), block.values.end(), low);
+        if (it == block.values.end() || *it != low) {
+            return;
+        }
+        block.values.erase(it);
+        --block.count;
+    }
+    if (block.count == 0) {
+        blocks.removeAt(index);
+    }
+}
+
+bool RoaringBitmap::contains(quint32 value) const {
+    const quint16 key = highBits(value);
+    const quint16 low = lowBits(value);
+    const qsizetype index = findBlock(key);
+    if (index == blocks.size() || blocks.at(index).key != key) {
+        return false;
+    }
+    const Block& block = blocks.at(index);
+    if (block.isDense()) {
+        return (block.bits.at(low >> 6) >> (low & 63)) & 1;
+    }
+    return std::binary_search(block.values.cbegin(), block.values.cend(), low);
+}
+
+qsizetype RoaringBitmap::cardinality() const {
+    qsizetype total = 0;
+    for (const Block& block : blocks) {
+        total += block.count;
+    }
+    return total;
+}
+
+RoaringBitmap::Block RoaringBitmap::unite(const Block& left, const Block& right) {
+    Block result;
+    result.key = left.key;
+    if (!left.isDense() && !right.isDense()) {
+        result.values.reserve(left.count + right.count);
+        std::set_union(left.values.cbegin(), left.values.cend(),
+                       right.values.cbegin(), right.values.cend(),
+                       std::back_inserter(result.values));
+        result.count = result.values.size();
+        if (result.count > ARRAY_LIMIT) {
+            toDense(result);
+        }
+        return result;
+    }
+
+    // Хотя бы один блок плотный: результат тоже плотный
+    const Block& dense = left.isDense() ? left : right;
+    const Block& other = left.isDense() ? right : left;
+    result.bits = dense.bits;
+    if (other.isDense()) {
+        for (qsizetype word = 0; word < BITMAP_WORDS; ++word) {
+            result.bits[word] |= other.bits.at(word);
+        }
+    } else {
+        for (quint16 low : other.values) {
+            result.bits[low >> 6] |= quint64(1) << (low & 63);
+        }
+    }
+    for (quint64 word : result.bits) {
+        result.count += qPopulationCount(word);
+    }
+    return result;
+}
+
+RoaringBitmap::Block RoaringBitmap::intersect(const Block& left, const Block& right) {
+    Block result;
+    result.key = left.key;
+    if (left.isDense() && right.isDense()) {
+        result.bits = left.bits;
+        for (qsizetype word = 0; word < BITMAP_WORDS; ++word) {
+            result.bits[word] &= right.bits.at(word);
+            result.count += qPopulationCount(result.bits.at(word));
+        }
+        toSparseIfSmall(result);
+        return result;
+    }
+
+    if (left.isDense() || right.isDense()) {
+        // Разреженный блок фильтруется по битовой карте плотного
+        const Block& dense = left.isDense() ? left : right;
+        const Block& sparse = left.isDense() ? right : left;
+        for (quint16 low : sparse.values) {
+            if ((dense.bits.at(low >> 6) >> (low & 63)) & 1) {
+                result.values.append(low);
+            }
+        }
+    } else {
+        std::set_intersection(left.values.cbegin(), left.values.cend(),
+                              right.values.cbegin(), right.values.cend(),
+                              std::back_inserter(result.values));
+    }
+    result.count = result.values.size();
+    return result;
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other) {
+    QList<Block> merged;
+    merged.reserve(blocks.size() + other.blocks.size());
+    qsizetype i = 0;
+    qsizetype j = 0;
+    while (i < blocks.size() || j < other.blocks.size()) {
+        if (j == other.blocks.size() || (i < blocks.size() && blocks.at(i).key < other.blocks.at(j).key)) {
+            merged.append(blocks.at(i++));
+        } else if (i == blocks.size() || other.blocks.at(j).key < blocks.at(i).key) {
+            merged.append(other.blocks.at(j++));
+        } else {
+            merged.append(unite(blocks.at(i++), other.blocks.at(j++)));
+        }
+    }
+    blocks = merged;
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other) {
+    QList<Block> common;
+    qsizetype i = 0;
+    qsizetype j = 0;
+    while (i < blocks.size() && j < other.blocks.size()) {
+        if (blocks.at(i).key < other.blocks.at(j).key) {
+            ++i;
+        } else if (other.blocks.at(j).key < blocks.at(i).key) {
+            ++j;
+        } else {
+            Block block = intersect(blocks.at(i++), other.blocks.at(j++));
+            if (block.count > 0) {
+                common.append(block);
+            }
+        }
+    }
+    blocks = common;
+    return *this;
+}
+
+QList<int> RoaringBitmap::toList() const {
+    QList<int> result;
+    result.reserve(cardinality());
+    for (const Block& block : blocks) {
+        const quint32 high = quint32(block.key) << 16;
+        if (block.isDense()) {
+            for (qsizetype word = 0; word < BITMAP_WORDS; ++word) {
+                for (quint64 bits = block.bits.at(word); bits != 0; bits &= bits - 1) {
+                    result.append(static_cast<int>(high | quint32(word * 64 + qCountTrailingZeroBits(bits))));
+                }
+            }
+        } else {
+            for (quint16 low : block.values) {
+                result.append(static_cast<int>(high | low));
+            }
+        }
+    }
+    return result;
+}
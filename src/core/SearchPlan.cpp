@@ -0,0 +1,29 @@
+// SearchPlan.cpp
+#include "core/SearchPlan.h"
+
+qint64 SearchPlan::totalNs() const {
+    qint64 total = 0;
+    for (const SearchPlanStep& step : steps) {
+        total += step.elapsedNs;
+    }
+    return total;
+}
+
+QString SearchPlan::toString() const {
+    QString text = QString("Путь доступа: %1 (стоимость %2, оценка %3 строк)\n")
+                       .arg(accessPath)
+                       .arg(estimatedCost, 0, 'f', 0)
+                       .arg(estimatedRows);
+    for (qsizetype i = 0; i < steps.size(); ++i) {
+        const SearchPlanStep& step = steps.at(i);
+        text += QString("  %1. %2 %3: оценка %4, строк %5 -> %6, %7 мс\n")
+                    .arg(i + 1)
+                    .arg(step.operation, step.detail)
+                    .arg(step.estimatedSelectivity, 0, 'f', 4)
+                    .arg(step.inputRows)
+                    .arg(step.outputRows)
+                    .arg(step.elapsedNs / 1e6, 0, 'f', 3);
+    }
+    text += QString("Всего: %1 мс").arg(totalNs() / 1e6, 0, 'f', 3);
+    return text;
+}
@@ -0,0 +1,36 @@
+// SearchSession.cpp
+#include "core/SearchSession.h"
+#include "core/TrackRepository.h"
+
+SearchSession::SearchSession(const TrackRepository& repository, qsizetype parallelThreshold)
+    : repository(repository), planner(repository), parallelThreshold(parallelThreshold)
+{
+}
+
+QList<int> SearchSession::search(const TrackSearchParams& params) {
+    // Позиции прошлого результата верны только для той же версии данных
+    refined = valid && generation == repository.getGeneration() &&
+              FilterPlanner::narrows(params, lastParams);
+    if (refined) {
+        lastSlots = planner.refine(params, lastParams, lastSlots, parallelThreshold);
+    } else {
+        lastSlots = planner.execute(params, parallelThreshold);
+    }
+    lastParams = params;
+    generation = repository.getGeneration();
+    valid = true;
+
+    const QList<int>& ids = repository.trackColumns().ids();
+    QList<int> result;
+    result.reserve(lastSlots.size());
+    for (qsizetype slot : lastSlots) {
+        result.append(ids.at(slot));
+    }
+    return result;
+}
+
+void SearchSession::reset() {
+    valid = false;
+    refined = false;
+    lastSlots.clear();
+}
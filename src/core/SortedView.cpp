@@ -0,0 +1,205 @@
+// SortedView.cpp
+#include "core/SortedView.h"
+#include <QtGlobal>
+#include <algorithm>
+
+bool SortedView::Entry::operator<(const Entry& other) const {
+    if (keysBefore(other)) {
+        return true;
+    }
+    return !other.keysBefore(*this) && id < other.id;
+}
+
+bool SortedView::Entry::keysBefore(const Entry& other) const {
+    if (number != other.number) {
+        return number < other.number;
+    }
+    if (const int order = primary.compare(other.primary); order != 0) {
+        return order < 0;
+    }
+    return secondary.compare(other.secondary) < 0;
+}
+
+bool SortedView::Entry::operator==(const Entry& other) const {
+    return id == other.id && number == other.number && primary == other.primary &&
+           secondary == other.secondary;
+}
+
+void SortedView::assign(QList<Entry> entries) {
+    std::sort(entries.begin(), entries.end());
+    chunks.clear();
+    for (qsizetype first = 0; first < entries.size(); first += CHUNK_SIZE) {
+        chunks.append(entries.mid(first, CHUNK_SIZE));
+    }
+    total = entries.size();
+    rebuildCounts();
+}
+
+void SortedView::insert(const Entry& entry) {
+    ++total;
+    if (chunks.isEmpty()) {
+        chunks.append(QList<Entry>{entry});
+        rebuildCounts();
+        return;
+    }
+    const qsizetype index = chunkFor(entry);
+    QList<Entry>& chunk = chunks[index];
+    chunk.insert(std::upper_bound(chunk.begin(), chunk.end(), entry), entry);
+    if (chunk.size() <= 2 * CHUNK_SIZE) {
+        addCount(index, 1);
+        return;
+    }
+    // Переполненный фрагмент делится пополам
+    QList<Entry> tail = chunk.mid(CHUNK_SIZE);
+    chunk.resize(CHUNK_SIZE);
+    chunks.insert(index + 1, tail);
+    rebuildCounts();
+}
+
+bool SortedView::remove(const Entry& entry) {
+    if (chunks.isEmpty()) {
+        return false;
+    }
+    const qsizetype index = chunkFor(entry);
+    QList<Entry>& chunk = chunks[index];
+    const auto it = std::lower_bound(chunk.begin(), chunk.end(), entry);
+    if (it == chunk.end() || !(*it == entry)) {
+        return false;
+    }
+    chunk.erase(it);
+    --total;
+    if (chunk.isEmpty()) {
+        chunks.removeAt(index);
+        rebuildCounts();
+    } else {
+        addCount(index, -1);
+    }
+    return true;
+}
+
+void SortedView::clear() {
+    chunks.clear();
+    counts.clear();
+    total = 0;
+}
+
+qsizetype SortedView::chunkFor(const Entry& entry) const {
+    const auto found = std::partition_point(chunks.cbegin(), chunks.cend(), [&entry](const QList<Entry>& chunk) {
+        return chunk.last() < entry;
+    });
+    return qMin(static_cast<qsizetype>(found - chunks.cbegin()), chunks.size() - 1);
+}
+
+SortedView::Position SortedView::locate(qsizetype index) const {
+    // Спуск по дереву Фенвика: наибольший префикс фрагментов, в котором
+    // не больше index записей
+    const qsizetype chunkCount = counts.size() - 1;
+    qsizetype step = 1;
+    while (step * 2 <= chunkCount) {
+        step *= 2;
+    }
+    Position position;
+    position.offset = index;
+    for (; step > 0; step /= 2) {
+        const qsizetype next = position.chunk + step;
+        if (next <= chunkCount && counts.at(next) <= position.offset) {
+            position.chunk = next;
+            position.offset -= counts.at(next);
+        }
+    }
+    return position;
+}
+
+void SortedView::advance(Position& position) const {
+    if (++position.offset == chunks.at(position.chunk).size()) {
+        ++position.chunk;
+        position.offset = 0;
+    }
+}
+
+void SortedView::retreat(Position& position) const {
+    if (position.offset-- == 0) {
+        --position.chunk;
+        position.offset = chunks.at(position.chunk).size() - 1;
+    }
+}
+
+void SortedView::rebuildCounts() {
+    const qsizetype chunkCount = chunks.size();
+    counts = QList<qsizetype>(chunkCount + 1, 0);
+    for (qsizetype node = 1; node <= chunkCount; ++node) {
+        counts[node] += chunks.at(node - 1).size();
+        const qsizetype parent = node + (node & -node);
+        if (parent <= chunkCount) {
+            counts[parent] += counts.at(node);
+        }
+    }
+}
+
+void SortedView::addCount(qsizetype chunk, qsizetype delta) {
+    for (qsizetype node = chunk + 1; node < counts.size(); node += node & -node) {
+        counts[node] += delta;
+    }
+}
+
+QList<int> SortedView::ids(const ResultWindow& window) const {
+    const qsizetype begin = window.begin(total);
+    const qsizetype end = window.end(total);
+    QList<int> result;
+    result.reserve(end - begin);
+    if (begin == end) {
+        return result;
+    }
+    if (window.ascending) {
+        Position position = locate(begin);
+        for (qsizetype i = begin; i < end; ++i) {
+            result.append(at(position).id);
+            advance(position);
+        }
+        return result;
+    }
+
+    // По убыванию группы равных ключей идут с конца, но внутри группы id
+    // по-прежнему возрастают. last — индекс записи, соответствующий
+    // текущей позиции окна при простом обращении порядка.
+    qsizetype last = total - 1 - begin;
+    Position cursor = locate(last);
+    qsizetype groupEnd = last + 1;
+    for (Position probe = cursor; groupEnd < total; ++groupEnd) {
+        advance(probe);
+        if (at(cursor).keysBefore(at(probe))) {
+            break;
+        }
+    }
+    for (;;) {
+        Position start = cursor;
+        qsizetype groupBegin = last;
+        while (groupBegin > 0) {
+            Position previous = start;
+            retreat(previous);
+            if (at(previous).keysBefore(at(start))) {
+                break;
+            }
+            start = previous;
+            --groupBegin;
+        }
+        Position position = start;
+        const qsizetype skipped = groupEnd - 1 - last;
+        for (qsizetype i = 0; i < skipped; ++i) {
+            advance(position);
+        }
+        for (qsizetype i = groupBegin + skipped; i < groupEnd && result.size() < end - begin; ++i) {
+            result.append(at(position).id);
+            if (i + 1 < groupEnd) {
+                advance(position);
+            }
+        }
+        if (result.size() == end - begin) {
+            return result;
+        }
+        groupEnd = groupBegin;
+        last = groupBegin - 1;
+        cursor = start;
+        retreat(cursor);
+    }
+}
@@ -0,0 +1,45 @@
+// StringPool.cpp
+#include "core/StringPool.h"
+#include "core/TextFolding.h"
+#include "core/SubstringKernel.h"
+
+quint32 StringPool::intern(const QString& value) {
+    const auto it = codes.constFind(value);
+    if (it != codes.constEnd()) {
+        return it.value();
+    }
+    const auto code = static_cast<quint32>(values.size());
+    values.append(value);
+    sortKeys.append(TextFolding::collationKey(value));
+    foldedValues.append(TextFolding::fold(value));
+    foldedIndex.insert(static_cast<int>(code), foldedValues.last());
+    codes.insert(value, code);
+    return code;
+}
+
+void StringPool::clear() {
+    codes.clear();
+    values.clear();
+    sortKeys.clear();
+    foldedValues.clear();
+    foldedIndex.clear();
+}
+
+QList<bool> StringPool::matchingCodes(const QString& foldedPattern) const {
+    if (foldedPattern.isEmpty()) {
+        return QList<bool>(values.size(), true);
+    }
+    QList<bool> matches(values.size(), false);
+    QList<int> candidates;
+    if (foldedIndex.candidates(foldedPattern, candidates)) {
+        for (int code : candidates) {
+            matches[code] = SubstringKernel::contains(foldedValues.at(code), foldedPattern);
+        }
+        return matches;
+    }
+    // Короткий запрос: проверяем все значения словаря
+    for (qsizetype code = 0; code < foldedValues.size(); ++code) {
+        matches[code] = SubstringKernel::contains(foldedValues.at(code), foldedPattern);
+    }
+    return matches;
+}
@@ -0,0 +1,203 @@
+// SubstringKernel.cpp
+#include "core/SubstringKernel.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SUBSTRING_KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SUBSTRING_KERNEL_X86) && !defined(_MSC_VER)
+#define SUBSTRING_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SUBSTRING_KERNEL_TARGET_AVX2
+#endif
+
+namespace {
+    using Kernel = bool (*)(const char16_t* text, qsizetype textSize,
+                            const char16_t* pattern, qsizetype patternSize);
+
+    // Совпадает ли середина образца (без первой и последней единицы) с текстом в позиции pos
+    inline bool middleMatches(const char16_t* text, qsizetype pos,
+                              const char16_t* pattern, qsizetype patternSize) {
+        return patternSize <= 2 ||
+               std::memcmp(text + pos + 1, pattern + 1, (patternSize - 2) * sizeof(char16_t)) == 0;
+    }
+
+    bool scalarContains(const char16_t* text, qsizetype textSize,
+                        const char16_t* pattern, qsizetype patternSize) {
+        const char16_t first = pattern[0];
+        const char16_t last = pattern[patternSize - 1];
+        for (qsizetype pos = 0; pos + patternSize <= textSize; ++pos) {
+            if (text[pos] == first && text[pos + patternSize - 1] == last &&
+                middleMatches(text, pos, pattern, patternSize)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+#ifdef SUBSTRING_KERNEL_X86
+    inline int lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // movemask_epi8 дает по два бита на 16-битную единицу: оставляем четные
+    constexpr unsigned EVEN_BITS = 0x55555555u;
+
+    bool sse2Contains(const char16_t* text, qsizetype textSize,
+                      const char16_t* pattern, qsizetype patternSize) {
+        constexpr qsizetype LANES = 8;
+        const __m128i first = _mm_set1_epi16(static_cast<short>(pattern[0]));
+        const __m128i last = _mm_set1_epi16(static_cast<short>(pattern[patternSize - 1]));
+
+        qsizetype pos = 0;
+        for (; pos + patternSize - 1 + LANES <= textSize; pos += LANES) {
+            const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+            const __m128i blockLast = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(text + pos + patternSize - 1));
+            const __m128i eq = _mm_and_si128(_mm_cmpeq_epi16(blockFirst, first),
+                                             _mm_cmpeq_epi16(blockLast, last));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq)) & EVEN_BITS;
+            while (mask != 0) {
+                const qsizetype candidate = pos + lowestBit(mask) / 2;
+                if (middleMatches(text, candidate, pattern, patternSize)) {
+                    return true;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return scalarContains(text + pos, textSize - pos, pattern, patternSize);
+    }
+
+    SUBSTRING_KERNEL_TARGET_AVX2
+    bool avx2Contains(const char16_t* text, qsizetype textSize,
+                      const char16_t* pattern, qsizetype patternSize) {
+        constexpr qsizetype LANES = 16;
+        const __m256i first = _mm256_set1_epi16(static_cast<short>(pattern[0]));
+        const __m256i last = _mm256_set1_epi16(static_cast<short>(pattern[patternSize - 1]));
+
+        qsizetype pos = 0;
+        for (; pos + patternSize - 1 + LANES <= textSize; pos += LANES) {
+            const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+            const __m256i blockLast = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(text + pos + patternSize - 1));
+            const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi16(blockFirst, first),
+                                                _mm256_cmpeq_epi16(blockLast, last));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq)) & EVEN_BITS;
+            while (mask != 0) {
+                const qsizetype candidate = pos + lowestBit(mask) / 2;
+                if (middleMatches(text, candidate, pattern, patternSize)) {
+                    return true;
+                }
+                mask &= mask - 1;
+            }
+        }
+        // Хвост короче одного 256-битного блока
+        return sse2Contains(text + pos, textSize - pos, pattern, patternSize);
+    }
+
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                                (_xgetbv(0) & 0x6) == 0x6;
+        if (!osSavesYmm) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif // SUBSTRING_KERNEL_X86
+
+    struct KernelChoice {
+        Kernel kernel;
+        const char* name;
+    };
+
+    KernelChoice selectKernel() {
+#ifdef SUBSTRING_KERNEL_X86
+        if (cpuHasAvx2()) {
+            return {avx2Contains, "avx2"};
+        }
+        return {sse2Contains, "sse2"}; // SSE2 входит в базовый набор x86-64
+#else
+        return {scalarContains, "scalar"};
+#endif
+    }
+
+    const KernelChoice& kernelChoice() {
+        static const KernelChoice choice = selectKernel();
+        return choice;
+    }
+
+    bool runKernel(Kernel kernel, const QString& text, const QString& pattern) {
+        const qsizetype patternSize = pattern.size();
+        if (patternSize == 0) {
+            return true;
+        }
+        if (patternSize > text.size()) {
+            return false;
+        }
+        return kernel(reinterpret_cast<const char16_t*>(text.constData()), text.size(),
+                      reinterpret_cast<const char16_t*>(pattern.constData()), patternSize);
+    }
+}
+
+bool SubstringKernel::contains(const QString& text, const QString& pattern) {
+    return runKernel(kernelChoice().kernel, text, pattern);
+}
+
+bool SubstringKernel::contains(const QString& text, const QString& pattern, Implementation implementation) {
+    if (!isAvailable(implementation)) {
+        return runKernel(scalarContains, text, pattern);
+    }
+    switch (implementation) {
+#ifdef SUBSTRING_KERNEL_X86
+    case Implementation::Avx2:
+        return runKernel(avx2Contains, text, pattern);
+    case Implementation::Sse2:
+        return runKernel(sse2Contains, text, pattern);
+#endif
+    default:
+        return runKernel(scalarContains, text, pattern);
+    }
+}
+
+bool SubstringKernel::isAvailable(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::Scalar:
+        return true;
+#ifdef SUBSTRING_KERNEL_X86
+    case Implementation::Sse2:
+        return true;
+    case Implementation::Avx2: {
+        static const bool available = cpuHasAvx2();
+        return available;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* SubstringKernel::implementationName() {
+    return kernelChoice().name;
+}
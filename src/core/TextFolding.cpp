@@ -0,0 +1,50 @@
+// TextFolding.cpp
+#include "core/TextFolding.h"
+
+namespace {
+    constexpr char16_t CYRILLIC_SMALL_IO = 0x0451;  // ё
+    constexpr char16_t CYRILLIC_SMALL_IE = 0x0435;  // е
+
+    // UTF-16 в порядке big-endian: побайтовое сравнение совпадает
+    // со сравнением кодовых единиц, а в нем кириллица а..я идет по алфавиту
+    void appendBigEndian(QByteArray& key, const QString& value) {
+        for (const QChar c : value) {
+            const char16_t unit = c.unicode();
+            key.append(static_cast<char>(unit >> 8));
+            key.append(static_cast<char>(unit & 0xFF));
+        }
+    }
+}
+
+QString TextFolding::fold(const QString& value) {
+    QString folded = value.normalized(QString::NormalizationForm_KC).toCaseFolded();
+    folded.replace(QChar(CYRILLIC_SMALL_IO), QChar(CYRILLIC_SMALL_IE));
+    return folded;
+}
+
+QByteArray TextFolding::collationKey(const QString& value) {
+    const QString primary = fold(value);
+    QByteArray key;
+    key.reserve((primary.size() + value.size() + 1) * 2);
+    appendBigEndian(key, primary);
+    // Разделитель меньше любого символа: короткая строка идет раньше своих продолжений
+    key.append('\0');
+    key.append('\0');
+    appendBigEndian(key, value);
+    return key;
+}
+
+QStringList TextFolding::words(const QString& foldedValue) {
+    QStringList result;
+    qsizetype start = -1;
+    for (qsizetype i = 0; i <= foldedValue.size(); ++i) {
+        const bool inWord = i < foldedValue.size() && foldedValue.at(i).isLetterOrNumber();
+        if (inWord && start < 0) {
+            start = i;
+        } else if (!inWord && start >= 0) {
+            result.append(foldedValue.mid(start, i - start));
+            start = -1;
+        }
+    }
+    return result;
+}
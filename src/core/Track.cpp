@@ -22,17 +22,6 @@ QString Track::getFormattedDuration() const {
     return QString("%1:%2").arg(minutes).arg(seconds, 2, 10, QChar('0'));
 }
 
-bool Track::matchesSearch(const QString& searchTerm) const {
-    if (searchTerm.isEmpty()) return true;
-
-    QString lowerSearch = searchTerm.toLower();
-
-    return title.toLower().contains(lowerSearch) ||
-           artist.toLower().contains(lowerSearch) ||
-           album.toLower().contains(lowerSearch) ||
-           genre.toLower().contains(lowerSearch);
-}
-
 bool Track::isFromYandexMusic() const {
     return !filePath.isEmpty() && 
            (filePath.startsWith("https://music.yandex.ru/") ||
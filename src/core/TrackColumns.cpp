@@ -0,0 +1,122 @@
+// TrackColumns.cpp
+#include "core/TrackColumns.h"
+#include "core/TextFolding.h"
+
+namespace {
+    template<typename Column>
+    void permuteColumn(Column& column, const QList<quint32>& order) {
+        Column reordered;
+        reordered.reserve(order.size());
+        for (quint32 slot : order) {
+            reordered.append(column.at(slot));
+        }
+        column = reordered;
+    }
+}
+
+void TrackColumns::countCode(QList<qsizetype>& counts, quint32 code, qsizetype delta) {
+    if (code >= static_cast<quint32>(counts.size())) {
+        counts.resize(code + 1, 0);
+    }
+    counts[code] += delta;
+}
+
+void TrackColumns::append(const Track& track) {
+    idColumn.append(track.getId());
+    yearColumn.append(track.getYear());
+    durationColumn.append(track.getDuration());
+    titleColumn.append(track.getTitle());
+    titleKeyColumn.append(TextFolding::collationKey(track.getTitle()));
+    foldedTitleColumn.append(TextFolding::fold(track.getTitle()));
+    artistColumn.append(artistDictionary.intern(track.getArtist()));
+    albumColumn.append(albumDictionary.intern(track.getAlbum()));
+    genreColumn.append(genreDictionary.intern(track.getGenre()));
+    filePathColumn.append(track.getFilePath());
+    yandexColumn.append(track.isFromYandexMusic());
+    countCode(artistCounts, artistColumn.last(), 1);
+    countCode(albumCounts, albumColumn.last(), 1);
+    countCode(genreCounts, genreColumn.last(), 1);
+}
+
+void TrackColumns::set(qsizetype slot, const Track& track) {
+    countCode(artistCounts, artistColumn.at(slot), -1);
+    countCode(albumCounts, albumColumn.at(slot), -1);
+    countCode(genreCounts, genreColumn.at(slot), -1);
+    idColumn[slot] = track.getId();
+    yearColumn[slot] = track.getYear();
+    durationColumn[slot] = track.getDuration();
+    titleColumn[slot] = track.getTitle();
+    titleKeyColumn[slot] = TextFolding::collationKey(track.getTitle());
+    foldedTitleColumn[slot] = TextFolding::fold(track.getTitle());
+    artistColumn[slot] = artistDictionary.intern(track.getArtist());
+    albumColumn[slot] = albumDictionary.intern(track.getAlbum());
+    genreColumn[slot] = genreDictionary.intern(track.getGenre());
+    filePathColumn[slot] = track.getFilePath();
+    yandexColumn[slot] = track.isFromYandexMusic();
+    countCode(artistCounts, artistColumn.at(slot), 1);
+    countCode(albumCounts, albumColumn.at(slot), 1);
+    countCode(genreCounts, genreColumn.at(slot), 1);
+}
+
+void TrackColumns::removeAt(qsizetype slot) {
+    countCode(artistCounts, artistColumn.at(slot), -1);
+    countCode(albumCounts, albumColumn.at(slot), -1);
+    countCode(genreCounts, genreColumn.at(slot), -1);
+    idColumn.removeAt(slot);
+    yearColumn.removeAt(slot);
+    durationColumn.removeAt(slot);
+    titleColumn.removeAt(slot);
+    titleKeyColumn.removeAt(slot);
+    foldedTitleColumn.removeAt(slot);
+    artistColumn.removeAt(slot);
+    albumColumn.removeAt(slot);
+    genreColumn.removeAt(slot);
+    filePathColumn.removeAt(slot);
+    yandexColumn.removeAt(slot);
+}
+
+void TrackColumns::permute(const QList<quint32>& order) {
+    permuteColumn(idColumn, order);
+    permuteColumn(yearColumn, order);
+    permuteColumn(durationColumn, order);
+    permuteColumn(titleColumn, order);
+    permuteColumn(titleKeyColumn, order);
+    permuteColumn(foldedTitleColumn, order);
+    permuteColumn(artistColumn, order);
+    permuteColumn(albumColumn, order);
+    permuteColumn(genreColumn, order);
+    permuteColumn(filePathColumn, order);
+    permuteColumn(yandexColumn, order);
+}
+
+void TrackColumns::clear() {
+    idColumn.clear();
+    yearColumn.clear();
+    durationColumn.clear();
+    titleColumn.clear();
+    titleKeyColumn.clear();
+    foldedTitleColumn.clear();
+    artistColumn.clear();
+    albumColumn.clear();
+    genreColumn.clear();
+    filePathColumn.clear();
+    yandexColumn.clear();
+    artistDictionary.clear();
+    albumDictionary.clear();
+    genreDictionary.clear();
+    artistCounts.clear();
+    albumCounts.clear();
+    genreCounts.clear();
+}
+
+Track TrackColumns::materialize(qsizetype slot) const {
+    TrackParams params;
+    params.title = titleColumn.at(slot);
+    params.artist = artist(slot);
+    params.album = album(slot);
+    params.year = yearColumn.at(slot);
+    params.genre = genre(slot);
+    params.duration = durationColumn.at(slot);
+    params.filePath = filePathColumn.at(slot);
+    return Track(idColumn.at(slot), params);
+}
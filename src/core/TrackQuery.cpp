@@ -0,0 +1,332 @@
+// TrackQuery.cpp
+#include "core/TrackQuery.h"
+#include "core/TextFolding.h"
+#include "exceptions/ParseException.h"
+
+namespace {
+    struct FieldName {
+        const char* name;
+        TrackQuery::Field field;
+    };
+
+    constexpr FieldName FIELD_NAMES[] = {
+        {"title", TrackQuery::Field::Title},
+        {"artist", TrackQuery::Field::Artist},
+        {"album", TrackQuery::Field::Album},
+        {"genre", TrackQuery::Field::Genre},
+        {"year", TrackQuery::Field::Year},
+        {"dur", TrackQuery::Field::Duration},
+        {"duration", TrackQuery::Field::Duration},
+        {"source", TrackQuery::Field::Source},
+    };
+
+    QString fieldName(TrackQuery::Field field) {
+        for (const FieldName& entry : FIELD_NAMES) {
+            if (entry.field == field) {
+                return entry.name;
+            }
+        }
+        return QString();
+    }
+
+    QString quoted(const QString& text) {
+        return QChar('"') + text + QChar('"');
+    }
+}
+
+// Разбор рекурсивным спуском: ИЛИ < И < отрицание < скобки и условия
+class TrackQueryParser {
+public:
+    explicit TrackQueryParser(const QString& text) : text(text) {}
+
+    TrackQuery parse() {
+        skipSpaces();
+        if (atEnd()) {
+            return query;
+        }
+        query.rootNode = parseOr();
+        skipSpaces();
+        if (!atEnd()) {
+            fail(pos, peek() == u')' ? "лишняя закрывающая скобка" : "неожиданный символ");
+        }
+        return query;
+    }
+
+private:
+    qsizetype parseOr() {
+        qsizetype left = parseAnd();
+        for (;;) {
+            skipSpaces();
+            if (!take(u'|') && !takeKeyword("OR")) {
+                return left;
+            }
+            const qsizetype right = parseAnd();
+            left = addNode(TrackQuery::NodeType::Or, left, right);
+        }
+    }
+
+    qsizetype parseAnd() {
+        qsizetype left = parseUnary();
+        for (;;) {
+            skipSpaces();
+            if (atEnd() || peek() == u')' || peek() == u'|' || atKeyword("OR")) {
+                return left;
+            }
+            takeKeyword("AND");
+            const qsizetype right = parseUnary();
+            left = addNode(TrackQuery::NodeType::And, left, right);
+        }
+    }
+
+    qsizetype parseUnary() {
+        skipSpaces();
+        if (atEnd() || peek() == u')' || peek() == u'|') {
+            fail(pos, "ожидалось условие");
+        }
+        if (take(u'-') || takeKeyword("NOT")) {
+            return addNode(TrackQuery::NodeType::Not, parseUnary(), -1);
+        }
+        if (take(u'(')) {
+            const qsizetype inner = parseOr();
+            skipSpaces();
+            if (!take(u')')) {
+                fail(pos, "ожидалась закрывающая скобка");
+            }
+            return inner;
+        }
+        return parseTerm();
+    }
+
+    qsizetype parseTerm() {
+        const qsizetype start = pos;
+        TrackQuery::Node node;
+        const QString word = readWord();
+        const qsizetype colon = word.indexOf(QChar(':'));
+        if (colon <= 0) {
+            // Слово или фраза без поля
+            node.text = TextFolding::fold(word.isEmpty() ? readQuoted() : word);
+            if (node.text.isEmpty()) {
+                fail(start, "пустое условие");
+            }
+            return addMatch(node);
+        }
+
+        const QString name = word.left(colon).toLower();
+        QString value = word.mid(colon + 1);
+        if (value.isEmpty() && !atEnd() && peek() == u'"') {
+            value = readQuoted();
+        }
+        if (value.isEmpty()) {
+            fail(start, QString("не задано значение поля %1").arg(name));
+        }
+
+        bool known = false;
+        for (const FieldName& entry : FIELD_NAMES) {
+            if (name == entry.name) {
+                node.field = entry.field;
+                known = true;
+            }
+        }
+        if (!known) {
+            fail(start, QString("неизвестное поле %1").arg(name));
+        }
+
+        switch (node.field) {
+        case TrackQuery::Field::Year:
+        case TrackQuery::Field::Duration:
+            parseBounds(value, node, start + colon + 1);
+            break;
+        case TrackQuery::Field::Source: {
+            const QString source = value.toLower();
+            if (source == "local") {
+                node.source = TrackSource::Local;
+            } else if (source == "yandex") {
+                node.source = TrackSource::YandexMusic;
+            } else {
+                fail(start + colon + 1, "источник должен быть local или yandex");
+            }
+            break;
+        }
+        default:
+            node.text = TextFolding::fold(value);
+            break;
+        }
+        return addMatch(node);
+    }
+
+    // Границы: n, a..b, a.., ..b, >n, >=n, <n, <=n
+    void parseBounds(const QString& value, TrackQuery::Node& node, qsizetype at) {
+        const bool duration = node.field == TrackQuery::Field::Duration;
+        if (value.startsWith(">=")) {
+            node.min = number(value.mid(2), duration, at);
+        } else if (value.startsWith(u'>')) {
+            // Строгая граница на пределе int дает пустой диапазон
+            const int bound = number(value.mid(1), duration, at);
+            if (bound == INT_MAX) {
+                fail(at, "пустой диапазон");
+            }
+            node.min = bound + 1;
+        } else if (value.startsWith("<=")) {
+            node.max = number(value.mid(2), duration, at);
+        } else if (value.startsWith(u'<')) {
+            const int bound = number(value.mid(1), duration, at);
+            if (bound == INT_MIN) {
+                fail(at, "пустой диапазон");
+            }
+            node.max = bound - 1;
+        } else if (const qsizetype dots = value.indexOf(".."); dots >= 0) {
+            const QString low = value.left(dots);
+            const QString high = value.mid(dots + 2);
+            if (low.isEmpty() && high.isEmpty()) {
+                fail(at, "у диапазона нет границ");
+            }
+            if (!low.isEmpty()) {
+                node.min = number(low, duration, at);
+            }
+            if (!high.isEmpty()) {
+                node.max = number(high, duration, at);
+            }
+        } else {
+            node.min = node.max = number(value, duration, at);
+        }
+        if (node.min > node.max) {
+            fail(at, "пустой диапазон");
+        }
+    }
+
+    // Целое число; длительность можно записать как минуты:секунды
+    int number(const QString& value, bool duration, qsizetype at) {
+        bool ok = false;
+        if (const qsizetype colon = value.indexOf(QChar(':')); duration && colon > 0) {
+            bool secondsOk = false;
+            const int minutes = value.left(colon).toInt(&ok);
+            const int seconds = value.mid(colon + 1).toInt(&secondsOk);
+            if (ok && secondsOk && seconds >= 0 && seconds < 60 &&
+                minutes >= 0 && minutes <= (INT_MAX - seconds) / 60) {
+                return minutes * 60 + seconds;
+            }
+            fail(at, "ожидалась длительность в виде м:сс");
+        }
+        const int result = value.toInt(&ok);
+        if (!ok) {
+            fail(at, QString("ожидалось число вместо %1").arg(value));
+        }
+        return result;
+    }
+
+    // Слово до пробела, скобки, | или кавычки
+    QString readWord() {
+        const qsizetype start = pos;
+        while (!atEnd() && !peek().isSpace() && peek() != u'(' && peek() != u')' &&
+               peek() != u'|' && peek() != u'"') {
+            ++pos;
+        }
+        return text.mid(start, pos - start);
+    }
+
+    QString readQuoted() {
+        const qsizetype start = pos;
+        if (!take(u'"')) {
+            fail(pos, "неожиданный символ");
+        }
+        const qsizetype close = text.indexOf(QChar('"'), pos);
+        if (close < 0) {
+            fail(start, "незакрытая кавычка");
+        }
+        const QString value = text.mid(pos, close - pos);
+        pos = close + 1;
+        return value;
+    }
+
+    bool atKeyword(const char* keyword) const {
+        const QString word(keyword);
+        if (text.mid(pos, word.size()) != word) {
+            return false;
+        }
+        const qsizetype end = pos + word.size();
+        return end == text.size() || text.at(end).isSpace() || text.at(end) == u'(';
+    }
+
+    bool takeKeyword(const char* keyword) {
+        if (!atKeyword(keyword)) {
+            return false;
+        }
+        pos += QString(keyword).size();
+        return true;
+    }
+
+    bool take(QChar c) {
+        if (atEnd() || peek() != c) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    void skipSpaces() {
+        while (!atEnd() && peek().isSpace()) {
+            ++pos;
+        }
+    }
+
+    bool atEnd() const { return pos >= text.size(); }
+    QChar peek() const { return text.at(pos); }
+
+    qsizetype addNode(TrackQuery::NodeType type, qsizetype left, qsizetype right) {
+        TrackQuery::Node node;
+        node.type = type;
+        node.left = left;
+        node.right = right;
+        return addMatch(node);
+    }
+
+    qsizetype addMatch(const TrackQuery::Node& node) {
+        query.nodeList.append(node);
+        return query.nodeList.size() - 1;
+    }
+
+    [[noreturn]] void fail(qsizetype at, const QString& reason) const {
+        throw ParseException(QString("Ошибка в запросе (позиция %1): %2").arg(at + 1).arg(reason));
+    }
+
+    const QString& text;
+    qsizetype pos = 0;
+    TrackQuery query;
+};
+
+TrackQuery TrackQuery::parse(const QString& query) {
+    return TrackQueryParser(query).parse();
+}
+
+QString TrackQuery::toString() const {
+    return rootNode < 0 ? QString() : nodeToString(rootNode);
+}
+
+QString TrackQuery::nodeToString(qsizetype index) const {
+    const Node& node = nodeList.at(index);
+    switch (node.type) {
+    case NodeType::And:
+        return "(" + nodeToString(node.left) + " AND " + nodeToString(node.right) + ")";
+    case NodeType::Or:
+        return "(" + nodeToString(node.left) + " OR " + nodeToString(node.right) + ")";
+    case NodeType::Not:
+        return "-" + nodeToString(node.left);
+    case NodeType::Match:
+        break;
+    }
+
+    switch (node.field) {
+    case Field::Any:
+        return quoted(node.text);
+    case Field::Year:
+    case Field::Duration: {
+        const QString low = node.min == INT_MIN ? QString() : QString::number(node.min);
+        const QString high = node.max == INT_MAX ? QString() : QString::number(node.max);
+        return fieldName(node.field) + ":" + low + ".." + high;
+    }
+    case Field::Source:
+        return fieldName(node.field) + (node.source == TrackSource::Local ? ":local" : ":yandex");
+    default:
+        return fieldName(node.field) + ":" + quoted(node.text);
+    }
+}
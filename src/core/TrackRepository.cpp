@@ -3,6 +3,8 @@
 #include "exceptions/TrackException.h"
 #include "exceptions/ValidationException.h"
 #include "core/Track.h"
+#include "core/TextFolding.h"
+#include <algorithm>
 
 TrackRepository::TrackRepository() = default;
 
@@ -11,7 +13,7 @@ void TrackRepository::addTrack(const Track& track) {
     int currentId = nextId;
     nextId = currentId + 1;
     newTrack.setId(currentId);
-    tracks.append(newTrack);
+    appendTrack(newTrack);
 }
 
 void TrackRepository::addTrack(const QString& title, const QString& artist,
@@ -23,7 +25,7 @@ void TrackRepository::addTrack(const QString& title, const QString& artist,
         throw ValidationException("artist", "исполнитель не может быть пустым");
     }
     Track track(nextId++, title, artist, album, year, genre, duration);
-    tracks.append(track);
+    appendTrack(track);
 }
 
 void TrackRepository::addTrack(const QString& title, const QString& artist,
@@ -45,27 +47,41 @@ void TrackRepository::addTrack(const QString& title, const QString& artist,
     int currentId = nextId;
     nextId = currentId + 1;
     Track track(currentId, params);
-    tracks.append(track);
+    appendTrack(track);
 }
 
 void TrackRepository::addTrackWithId(int id, const TrackParams& params) {
+    if (idIndex.contains(id)) {
+        throw TrackException(QString("Трек с ID %1 уже существует в каталоге").arg(id));
+    }
     Track track(id, params);
-    tracks.append(track);
+    appendTrack(track);
     if (id >= nextId) {
         nextId = id + 1;
     }
 }
 
 bool TrackRepository::removeTrack(int id) {
-    for (auto it = tracks.begin(); it != tracks.end(); ++it) {
-        // Используем перегруженный оператор == для сравнения по ID
-        if (it->getId() == id) {
-            tracks.erase(it);
-            return true;
-        }
+    const auto it = idIndex.constFind(id);
+    if (it == idIndex.constEnd()) {
+        // Возвращаем false, если трек не найден (для обратной совместимости)
+        return false;
     }
-    // Возвращаем false, если трек не найден (для обратной совместимости)
-    return false;
+    const qsizetype slot = it.value();
+    idIndex.erase(it);
+    titleIndex.remove(id, columns.foldedTitles().at(slot));
+    wordIndex.remove(id, wordText(slot));
+    textIndex.remove(id);
+    indexViews(slot, false);
+    yearIndex.remove(columns.years().at(slot), id);
+    durationIndex.remove(columns.durations().at(slot), id);
+    indexBitmaps(slot, false);
+    tracks.removeAt(slot);
+    columns.removeAt(slot);
+    // Треки после удаленного сдвинулись на одну позицию
+    reindexFrom(slot);
+    ++generation;
+    return true;
 }
 
 bool TrackRepository::updateTrack(int id, const Track& updatedTrack) {
@@ -76,33 +92,92 @@ bool TrackRepository::updateTrack(int id, const Track& updatedTrack) {
         throw ValidationException("artist", "исполнитель не может быть пустым");
     }
     
-    for (Track& track : tracks) {
-        if (track.getId() == id) {
-            track = updatedTrack;
-            track.setId(id); // Сохраняем оригинальный ID
-            return true;
-        }
+    const qsizetype slot = idIndex.value(id, -1);
+    if (slot < 0) {
+        // Возвращаем false, если трек не найден (для обратной совместимости)
+        return false;
+    }
+    Track track = updatedTrack;
+    track.setId(id); // Сохраняем оригинальный ID
+    const QString oldFoldedTitle = columns.foldedTitles().at(slot);
+    const int oldYear = columns.years().at(slot);
+    const int oldDuration = columns.durations().at(slot);
+    const QString oldWords = wordText(slot);
+    indexBitmaps(slot, false);
+    indexViews(slot, false);
+    columns.set(slot, track);
+    indexBitmaps(slot, true);
+    indexViews(slot, true);
+    if (const QString& foldedTitle = columns.foldedTitles().at(slot); foldedTitle != oldFoldedTitle) {
+        titleIndex.remove(id, oldFoldedTitle);
+        titleIndex.insert(id, foldedTitle);
+    }
+    if (const QString words = wordText(slot); words != oldWords) {
+        wordIndex.remove(id, oldWords);
+        wordIndex.insert(id, words);
+    }
+    indexText(slot);
+    if (track.getYear() != oldYear) {
+        yearIndex.remove(oldYear, id);
+        yearIndex.insert(track.getYear(), id);
+    }
+    if (track.getDuration() != oldDuration) {
+        durationIndex.remove(oldDuration, id);
+        durationIndex.insert(track.getDuration(), id);
     }
-    // Возвращаем false, если трек не найден (для обратной совместимости)
-    return false;
+    // Трек в хранилище разделяет строки со словарями колонок
+    tracks[slot] = columns.materialize(slot);
+    ++generation;
+    return true;
 }
 
-Track* TrackRepository::findTrackById(int id) {
-    for (Track& track : tracks) {
-        if (track.getId() == id) {
-            return &track;
-        }
+const Track* TrackRepository::findTrackById(int id) const {
+    const qsizetype slot = idIndex.value(id, -1);
+    return slot < 0 ? nullptr : &tracks[slot];
+}
+
+bool TrackRepository::titleCandidateSlots(const QString& foldedTitle, QList<qsizetype>& slots) const {
+    QList<int> ids;
+    if (!titleIndex.candidates(foldedTitle, ids)) {
+        return false;
     }
-    return nullptr;
+    slots = slotsOf(ids);
+    return true;
 }
 
-const Track* TrackRepository::findTrackById(int id) const {
-    for (const Track& track : tracks) {
-        if (track.getId() == id) {
-            return &track;
-        }
+const RoaringBitmap& TrackRepository::genreBitmap(quint32 genreCode) const {
+    static const RoaringBitmap empty;
+    return genreCode < static_cast<quint32>(genreBitmaps.size()) ? genreBitmaps.at(genreCode) : empty;
+}
+
+const RoaringBitmap& TrackRepository::sourceBitmap(TrackSource source) const {
+    return source == TrackSource::YandexMusic ? yandexTracks : localTracks;
+}
+
+void TrackRepository::indexBitmaps(qsizetype slot, bool add) {
+    const quint32 id = static_cast<quint32>(columns.ids().at(slot));
+    const quint32 genreCode = columns.genreCodes().at(slot);
+    if (genreCode >= static_cast<quint32>(genreBitmaps.size())) {
+        genreBitmaps.resize(genreCode + 1);
+    }
+    RoaringBitmap& source = columns.yandexFlags().at(slot) ? yandexTracks : localTracks;
+    if (add) {
+        genreBitmaps[genreCode].add(id);
+        source.add(id);
+    } else {
+        genreBitmaps[genreCode].remove(id);
+        source.remove(id);
     }
-    return nullptr;
+}
+
+QList<qsizetype> TrackRepository::slotsOf(const QList<int>& ids) const {
+    QList<qsizetype> slots;
+    slots.reserve(ids.size());
+    for (int id : ids) {
+        slots.append(idIndex.value(id));
+    }
+    std::sort(slots.begin(), slots.end());
+    return slots;
 }
 
 void TrackRepository::updateNextId() {
@@ -115,7 +190,136 @@ void TrackRepository::updateNextId() {
     nextId = maxId + 1;
 }
 
-void TrackRepository::setTracks(const QList<Track>& newTracks) {
-    tracks = newTracks;
+void TrackRepository::applyPermutation(const QList<quint32>& order) {
+    // Уже упорядоченное хранилище не трогаем: поколение не меняется,
+    // и кэш поиска с сессиями остаются действительными
+    qsizetype unchanged = 0;
+    while (unchanged < order.size() && order.at(unchanged) == static_cast<quint32>(unchanged)) {
+        ++unchanged;
+    }
+    if (unchanged == order.size()) {
+        return;
+    }
+    QList<Track> reordered;
+    reordered.reserve(order.size());
+    for (quint32 slot : order) {
+        reordered.append(tracks.at(slot));
+    }
+    tracks = reordered;
+    columns.permute(order);
+    reindexFrom(0);
+    ++generation;
+}
+
+void TrackRepository::appendTrack(const Track& track) {
+    idIndex.insert(track.getId(), tracks.size());
+    columns.append(track);
+    titleIndex.insert(track.getId(), columns.foldedTitles().last());
+    wordIndex.insert(track.getId(), wordText(columns.size() - 1));
+    indexText(columns.size() - 1);
+    indexViews(columns.size() - 1, true);
+    yearIndex.insert(track.getYear(), track.getId());
+    durationIndex.insert(track.getDuration(), track.getId());
+    indexBitmaps(columns.size() - 1, true);
+    // Трек в хранилище разделяет строки со словарями колонок
+    tracks.append(columns.materialize(tracks.size()));
+    ++generation;
+}
+
+QString TrackRepository::wordText(qsizetype slot) const {
+    return columns.foldedTitles().at(slot) + QChar(' ') + TextFolding::fold(columns.artist(slot));
+}
+
+void TrackRepository::indexText(qsizetype slot) {
+    textIndex.insert(columns.ids().at(slot), {columns.foldedTitles().at(slot),
+                                              TextFolding::fold(columns.artist(slot)),
+                                              TextFolding::fold(columns.album(slot)),
+                                              TextFolding::fold(columns.genre(slot))});
+}
+
+SortedView::Entry TrackRepository::viewEntry(TrackOrder order, qsizetype slot) const {
+    // Ключи те же, что у TrackOrdering: строки сравниваются по ключам сортировки
+    SortedView::Entry entry;
+    entry.id = columns.ids().at(slot);
+    const QByteArray& titleKey = columns.titleKeys().at(slot);
+    const QByteArray& artistKey = columns.artistPool().sortKey(columns.artistCodes().at(slot));
+    switch (order) {
+    case TrackOrder::Artist:
+        entry.primary = artistKey;
+        entry.secondary = titleKey;
+        break;
+    case TrackOrder::Album:
+        entry.primary = columns.albumPool().sortKey(columns.albumCodes().at(slot));
+        entry.secondary = titleKey;
+        break;
+    case TrackOrder::Genre:
+        entry.primary = columns.genrePool().sortKey(columns.genreCodes().at(slot));
+        entry.secondary = titleKey;
+        break;
+    case TrackOrder::Year:
+        entry.number = columns.years().at(slot);
+        entry.primary = titleKey;
+        break;
+    case TrackOrder::Duration:
+        entry.number = columns.durations().at(slot);
+        entry.primary = titleKey;
+        break;
+    default:
+        entry.primary = titleKey;
+        entry.secondary = artistKey;
+        break;
+    }
+    return entry;
+}
+
+void TrackRepository::indexViews(qsizetype slot, bool add) {
+    if (sortedViews.isEmpty()) {
+        return;
+    }
+    for (qsizetype view = 0; view < sortedViews.size(); ++view) {
+        const SortedView::Entry entry = viewEntry(static_cast<TrackOrder>(view + 1), slot);
+        if (add) {
+            sortedViews[view].insert(entry);
+        } else {
+            sortedViews[view].remove(entry);
+        }
+    }
+}
+
+QList<int> TrackRepository::orderedIds(const ResultWindow& window) const {
+    if (window.orderBy == TrackOrder::Catalog) {
+        const QList<int>& ids = columns.ids();
+        const qsizetype count = ids.size();
+        const qsizetype begin = window.begin(count);
+        const qsizetype end = window.end(count);
+        QList<int> result;
+        result.reserve(end - begin);
+        for (qsizetype i = begin; i < end; ++i) {
+            result.append(ids.at(window.ascending ? i : count - 1 - i));
+        }
+        return result;
+    }
+
+    if (sortedViews.isEmpty()) {
+        // Первый запрос строит все представления, дальше они поддерживаются
+        for (TrackOrder order : {TrackOrder::Title, TrackOrder::Artist, TrackOrder::Year,
+                                 TrackOrder::Duration, TrackOrder::Album, TrackOrder::Genre}) {
+            QList<SortedView::Entry> entries;
+            entries.reserve(columns.size());
+            for (qsizetype slot = 0; slot < columns.size(); ++slot) {
+                entries.append(viewEntry(order, slot));
+            }
+            SortedView view;
+            view.assign(entries);
+            sortedViews.append(view);
+        }
+    }
+    return sortedViews.at(static_cast<int>(window.orderBy) - 1).ids(window);
+}
+
+void TrackRepository::reindexFrom(qsizetype slot) {
+    for (qsizetype i = slot; i < tracks.size(); ++i) {
+        idIndex.insert(tracks[i].getId(), i);
+    }
 }
 
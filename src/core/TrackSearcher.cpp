@@ -1,134 +1,435 @@
 // TrackSearcher.cpp
 #include "core/TrackSearcher.h"
 #include "core/TrackRepository.h"
+#include "core/TrackColumns.h"
 #include "core/TrackSearchParams.h"
+#include "core/TextFolding.h"
+#include "core/SubstringKernel.h"
+#include "core/TrackOrdering.h"
+#include "core/TrackQuery.h"
+#include "exceptions/ValidationException.h"
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace {
+    // Проверка по свернутой теневой колонке, без выделения памяти на строку
+    bool titleContains(const TrackColumns& columns, qsizetype slot, const QString& foldedPattern) {
+        return SubstringKernel::contains(columns.foldedTitles().at(slot), foldedPattern);
+    }
+
+    // Позиции треков, удовлетворяющих предикату
+    template<typename Predicate>
+    QList<qsizetype> matchingSlots(qsizetype count, Predicate matches) {
+        QList<qsizetype> result;
+        for (qsizetype slot = 0; slot < count; ++slot) {
+            if (matches(slot)) {
+                result.append(slot);
+            }
+        }
+        return result;
+    }
+
+    // То же, но проверяются только переданные позиции
+    template<typename Predicate>
+    QList<qsizetype> matchingSlots(const QList<qsizetype>& slots, Predicate matches) {
+        QList<qsizetype> result;
+        for (qsizetype slot : slots) {
+            if (matches(slot)) {
+                result.append(slot);
+            }
+        }
+        return result;
+    }
+
+    // Позиции, у которых код словарной колонки отмечен в таблице совпадений
+    QList<qsizetype> slotsByCodes(const QList<quint32>& codeColumn, const QList<bool>& matches) {
+        const quint32* codes = codeColumn.constData();
+        return matchingSlots(codeColumn.size(), [&matches, codes](qsizetype slot) {
+            return matches.at(codes[slot]);
+        });
+    }
+
+    // Копии треков по позициям: единственное место, где строки собираются заново
+    QList<Track> materialize(const TrackColumns& columns, const QList<qsizetype>& slots) {
+        QList<Track> result;
+        result.reserve(slots.size());
+        for (qsizetype slot : slots) {
+            result.append(columns.materialize(slot));
+        }
+        return result;
+    }
+
+    QList<int> idsAt(const TrackColumns& columns, const QList<qsizetype>& slots) {
+        const int* ids = columns.ids().constData();
+        QList<int> result;
+        result.reserve(slots.size());
+        for (qsizetype slot : slots) {
+            result.append(ids[slot]);
+        }
+        return result;
+    }
+
+    // Вычисление запроса по колонкам: каждый узел получает отсортированный
+    // список позиций-кандидатов и возвращает его подмножество. Условие-лист
+    // проверяется одним циклом по своей колонке, И сужает кандидатов для
+    // правого условия, ИЛИ проверяет правое условие только на оставшихся.
+    class QueryEvaluator {
+    public:
+        QueryEvaluator(const TrackRepository& repository, const TrackQuery& query)
+            : repository(repository), columns(repository.trackColumns()), query(query)
+        {
+            // Таблицы совпадений словарей вычисляются один раз на запрос
+            codeTables.resize(query.nodes().size());
+            for (qsizetype i = 0; i < query.nodes().size(); ++i) {
+                const TrackQuery::Node& node = query.nodes().at(i);
+                if (node.type != TrackQuery::NodeType::Match) {
+                    continue;
+                }
+                const bool any = node.field == TrackQuery::Field::Any;
+                CodeTables& tables = codeTables[i];
+                if (any || node.field == TrackQuery::Field::Artist) {
+                    tables.artists = columns.artistPool().matchingCodes(node.text);
+                }
+                if (any || node.field == TrackQuery::Field::Album) {
+                    tables.albums = columns.albumPool().matchingCodes(node.text);
+                }
+                if (any || node.field == TrackQuery::Field::Genre) {
+                    tables.genres = columns.genrePool().matchingCodes(node.text);
+                }
+            }
+        }
+
+        QList<qsizetype> evaluate(qsizetype index, const QList<qsizetype>& candidates) const {
+            if (candidates.isEmpty()) {
+                return candidates;
+            }
+            const TrackQuery::Node& node = query.nodes().at(index);
+            switch (node.type) {
+            case TrackQuery::NodeType::And:
+                return evaluate(node.right, evaluate(node.left, candidates));
+            case TrackQuery::NodeType::Or: {
+                const QList<qsizetype> left = evaluate(node.left, candidates);
+                const QList<qsizetype> right = evaluate(node.right, difference(candidates, left));
+                QList<qsizetype> result;
+                result.reserve(left.size() + right.size());
+                std::merge(left.cbegin(), left.cend(), right.cbegin(), right.cend(), std::back_inserter(result));
+                return result;
+            }
+            case TrackQuery::NodeType::Not:
+                return difference(candidates, evaluate(node.left, candidates));
+            case TrackQuery::NodeType::Match:
+                break;
+            }
+            return match(node, codeTables.at(index), candidates);
+        }
+
+    private:
+        struct CodeTables {
+            QList<bool> artists;
+            QList<bool> albums;
+            QList<bool> genres;
+        };
+
+        static QList<qsizetype> difference(const QList<qsizetype>& from, const QList<qsizetype>& removed) {
+            QList<qsizetype> result;
+            result.reserve(from.size() - removed.size());
+            std::set_difference(from.cbegin(), from.cend(), removed.cbegin(), removed.cend(),
+                                std::back_inserter(result));
+            return result;
+        }
+
+        QList<qsizetype> match(const TrackQuery::Node& node, const CodeTables& tables,
+                               const QList<qsizetype>& candidates) const {
+            switch (node.field) {
+            case TrackQuery::Field::Title: {
+                // Триграммный индекс отсекает позиции без нужных триграмм
+                QList<qsizetype> indexed;
+                QList<qsizetype> narrowed;
+                const QList<qsizetype>* slots = &candidates;
+                if (repository.titleCandidateSlots(node.text, indexed)) {
+                    std::set_intersection(candidates.cbegin(), candidates.cend(), indexed.cbegin(),
+                                          indexed.cend(), std::back_inserter(narrowed));
+                    slots = &narrowed;
+                }
+                return matchingSlots(*slots, [this, &node](qsizetype slot) {
+                    return titleContains(columns, slot, node.text);
+                });
+            }
+            case TrackQuery::Field::Artist:
+                return byCode(candidates, columns.artistCodes(), tables.artists);
+            case TrackQuery::Field::Album:
+                return byCode(candidates, columns.albumCodes(), tables.albums);
+            case TrackQuery::Field::Genre:
+                return byCode(candidates, columns.genreCodes(), tables.genres);
+            case TrackQuery::Field::Year:
+                return inRange(candidates, columns.years(), node.min, node.max);
+            case TrackQuery::Field::Duration:
+                return inRange(candidates, columns.durations(), node.min, node.max);
+            case TrackQuery::Field::Source: {
+                const bool* flags = columns.yandexFlags().constData();
+                const bool yandex = node.source == TrackSource::YandexMusic;
+                return matchingSlots(candidates, [flags, yandex](qsizetype slot) {
+                    return flags[slot] == yandex;
+                });
+            }
+            case TrackQuery::Field::Any:
+                break;
+            }
+
+            const quint32* artistCodes = columns.artistCodes().constData();
+            const quint32* albumCodes = columns.albumCodes().constData();
+            const quint32* genreCodes = columns.genreCodes().constData();
+            return matchingSlots(candidates, [&](qsizetype slot) {
+                return tables.artists.at(artistCodes[slot]) || tables.albums.at(albumCodes[slot]) ||
+                       tables.genres.at(genreCodes[slot]) || titleContains(columns, slot, node.text);
+            });
+        }
+
+        static QList<qsizetype> byCode(const QList<qsizetype>& candidates, const QList<quint32>& codeColumn,
+                                       const QList<bool>& matches) {
+            const quint32* codes = codeColumn.constData();
+            return matchingSlots(candidates, [codes, &matches](qsizetype slot) {
+                return matches.at(codes[slot]);
+            });
+        }
+
+        static QList<qsizetype> inRange(const QList<qsizetype>& candidates, const QList<int>& column,
+                                        int min, int max) {
+            const int* values = column.constData();
+            return matchingSlots(candidates, [values, min, max](qsizetype slot) {
+                return values[slot] >= min && values[slot] <= max;
+            });
+        }
+
+        const TrackRepository& repository;
+        const TrackColumns& columns;
+        const TrackQuery& query;
+        QList<CodeTables> codeTables;
+    };
+
+}
 
 TrackSearcher::TrackSearcher(const TrackRepository& repository)
-    : repository(repository)
+    : repository(repository), planner(repository), parallelThreshold(DEFAULT_PARALLEL_THRESHOLD)
 {
 }
 
+void TrackSearcher::setParallelThreshold(qsizetype threshold) {
+    parallelThreshold = threshold;
+}
+
+qsizetype TrackSearcher::getParallelThreshold() const {
+    return parallelThreshold;
+}
+
 QList<Track> TrackSearcher::findTracksByTitle(const QString& title) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
-    for (const Track& track : tracks) {
-        if (track.getTitle().contains(title, Qt::CaseInsensitive)) {
-            result.append(track);
-        }
+    const TrackColumns& columns = repository.trackColumns();
+    const QString foldedTitle = TextFolding::fold(title);
+    auto matches = [&columns, &foldedTitle](qsizetype slot) {
+        return titleContains(columns, slot, foldedTitle);
+    };
+
+    QList<qsizetype> slots;
+    if (repository.titleCandidateSlots(foldedTitle, slots)) {
+        return materialize(columns, matchingSlots(slots, matches));
     }
-    return result;
+    return materialize(columns, matchingSlots(columns.size(), matches));
 }
 
 QList<Track> TrackSearcher::findTracksByArtist(const QString& artist) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
-    for (const Track& track : tracks) {
-        if (track.getArtist().contains(artist, Qt::CaseInsensitive)) {
-            result.append(track);
-        }
-    }
-    return result;
+    const TrackColumns& columns = repository.trackColumns();
+    return materialize(columns, slotsByCodes(columns.artistCodes(),
+                                             columns.artistPool().matchingCodes(TextFolding::fold(artist))));
 }
 
 QList<Track> TrackSearcher::findTracksByAlbum(const QString& album) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
-    for (const Track& track : tracks) {
-        if (track.getAlbum().contains(album, Qt::CaseInsensitive)) {
-            result.append(track);
-        }
-    }
-    return result;
+    const TrackColumns& columns = repository.trackColumns();
+    return materialize(columns, slotsByCodes(columns.albumCodes(),
+                                             columns.albumPool().matchingCodes(TextFolding::fold(album))));
 }
 
 QList<Track> TrackSearcher::findTracksByGenre(const QString& genre) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
-    for (const Track& track : tracks) {
-        if (track.getGenre().contains(genre, Qt::CaseInsensitive)) {
-            result.append(track);
-        }
-    }
-    return result;
+    const TrackColumns& columns = repository.trackColumns();
+    return materialize(columns, slotsByCodes(columns.genreCodes(),
+                                             columns.genrePool().matchingCodes(TextFolding::fold(genre))));
 }
 
 QList<Track> TrackSearcher::findTracksByYearRange(int startYear, int endYear) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
-    for (const Track& track : tracks) {
-        if (track.getYear() >= startYear && track.getYear() <= endYear) {
-            result.append(track);
-        }
+    // Диапазон берется из упорядоченного индекса годов за O(log n + k)
+    const QList<qsizetype> slots = repository.slotsOf(repository.yearRangeIndex().ids(startYear, endYear));
+    return materialize(repository.trackColumns(), slots);
+}
+
+QList<Track> TrackSearcher::searchByQuery(const QString& query) const {
+    return materialize(repository.trackColumns(), querySlots(TrackQuery::parse(query)));
+}
+
+QList<qsizetype> TrackSearcher::querySlots(const TrackQuery& query) const {
+    QList<qsizetype> all(repository.trackColumns().size());
+    std::iota(all.begin(), all.end(), qsizetype(0));
+    if (query.isEmpty()) {
+        return all;
     }
-    return result;
+    return QueryEvaluator(repository, query).evaluate(query.root(), all);
 }
 
-QList<Track> TrackSearcher::searchTracks(const QString& searchTerm) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
-    for (const Track& track : tracks) {
-        if (track.matchesSearch(searchTerm)) {
-            result.append(track);
-        }
+QList<Track> TrackSearcher::rankedSearch(const QString& query, qsizetype limit) const {
+    const QList<RelevanceIndex::Hit> hits = repository.relevanceIndex().search(TextFolding::fold(query), limit);
+    QList<qsizetype> slots;
+    slots.reserve(hits.size());
+    for (const RelevanceIndex::Hit& hit : hits) {
+        slots.append(repository.findSlot(hit.key));
     }
-    return result;
+    return materialize(repository.trackColumns(), slots);
 }
 
-namespace {
-    bool matchesFilters(const Track& track, const TrackSearchParams& params) {
-        // Фильтр по названию
-        if (!params.title.isEmpty() && !track.getTitle().contains(params.title, Qt::CaseInsensitive)) {
-            return false;
-        }
+QList<Track> TrackSearcher::fuzzySearch(const QString& query, int maxDistance) const {
+    if (maxDistance < 0 || maxDistance > FuzzyIndex::MAX_DISTANCE) {
+        throw ValidationException("maxDistance", QString("допустимо от 0 до %1 правок")
+                                                     .arg(FuzzyIndex::MAX_DISTANCE));
+    }
+    const QList<FuzzyIndex::Match> matches =
+        repository.fuzzyWords().search(TextFolding::fold(query), maxDistance);
+    QList<qsizetype> slots;
+    slots.reserve(matches.size());
+    for (const FuzzyIndex::Match& match : matches) {
+        slots.append(repository.findSlot(match.key));
+    }
+    return materialize(repository.trackColumns(), slots);
+}
 
-        // Фильтр по исполнителю
-        if (!params.artist.isEmpty() && !track.getArtist().contains(params.artist, Qt::CaseInsensitive)) {
-            return false;
-        }
+QList<Track> TrackSearcher::searchTracks(const QString& searchTerm) const {
+    return materialize(repository.trackColumns(), searchSlots(searchTerm));
+}
 
-        // Фильтр по альбому
-        if (!params.album.isEmpty() && !track.getAlbum().contains(params.album, Qt::CaseInsensitive)) {
-            return false;
-        }
+QList<qsizetype> TrackSearcher::searchSlots(const QString& searchTerm) const {
+    const TrackColumns& columns = repository.trackColumns();
+    const QString folded = TextFolding::fold(searchTerm);
+    if (folded.isEmpty()) {
+        return matchingSlots(columns.size(), [](qsizetype) { return true; });
+    }
 
-        // Фильтр по жанру
-        if (!params.genre.isEmpty() && !track.getGenre().contains(params.genre, Qt::CaseInsensitive)) {
-            return false;
-        }
+    const QList<bool> artistMatches = columns.artistPool().matchingCodes(folded);
+    const QList<bool> albumMatches = columns.albumPool().matchingCodes(folded);
+    const QList<bool> genreMatches = columns.genrePool().matchingCodes(folded);
+    const bool anyCodeMatches = artistMatches.contains(true) || albumMatches.contains(true) ||
+                                genreMatches.contains(true);
 
-        // Фильтр по году
-        if (params.minYear >= 1900 && track.getYear() < params.minYear) {
-            return false;
-        }
-        if (params.maxYear <= 2100 && params.maxYear >= 1900 && track.getYear() > params.maxYear) {
-            return false;
-        }
+    QList<qsizetype> slots;
+    const bool indexed = repository.titleCandidateSlots(folded, slots);
+    if (indexed && !anyCodeMatches) {
+        // Совпасть может только название: проверяем кандидатов из индекса
+        return matchingSlots(slots, [&columns, &folded](qsizetype slot) {
+            return titleContains(columns, slot, folded);
+        });
+    }
 
-        // Фильтр по длительности
-        if (params.minDuration > 1 && track.getDuration() < params.minDuration) {
-            return false;
-        }
-        if (params.maxDuration < 3600 && track.getDuration() > params.maxDuration) {
-            return false;
+    // Отмечаем подтвержденные совпадения по названию, остальное решают коды словарей
+    QList<bool> titleMatches(columns.size(), false);
+    if (indexed) {
+        for (qsizetype slot : slots) {
+            titleMatches[slot] = titleContains(columns, slot, folded);
         }
-
-        return true;
     }
+    const quint32* artistCodes = columns.artistCodes().constData();
+    const quint32* albumCodes = columns.albumCodes().constData();
+    const quint32* genreCodes = columns.genreCodes().constData();
+    return matchingSlots(columns.size(), [&](qsizetype slot) {
+        if (artistMatches.at(artistCodes[slot]) || albumMatches.at(albumCodes[slot]) ||
+            genreMatches.at(genreCodes[slot])) {
+            return true;
+        }
+        return indexed ? titleMatches.at(slot) : titleContains(columns, slot, folded);
+    });
 }
 
 QList<Track> TrackSearcher::searchTracksWithFilters(const TrackSearchParams& params) const {
-    QList<Track> result;
-    QList<Track> tracks = repository.findAllTracks();
+    return runFilters(params, nullptr);
+}
 
-    for (const Track& track : tracks) {
-        if (matchesFilters(track, params)) {
-            result.append(track);
-        }
+QList<qsizetype> TrackSearcher::searchSlotsWithFilters(const TrackSearchParams& params) const {
+    return planner.execute(params, parallelThreshold);
+}
+
+QList<int> TrackSearcher::pageIds(const QList<qsizetype>& slots, const ResultWindow& window) const {
+    const TrackColumns& columns = repository.trackColumns();
+    const qsizetype begin = window.begin(slots.size());
+    const qsizetype end = window.end(slots.size());
+    if (window.orderBy == TrackOrder::Catalog && window.ascending) {
+        // Позиции уже идут в порядке каталога
+        return idsAt(columns, slots.mid(begin, end - begin));
     }
 
-    return result;
+    // Порядок строгий и полный (равные ключи — по id), поэтому страницы
+    // не пересекаются, не теряют треков и совпадают с SortedView
+    const QList<SortKey> spec{SortKey{window.orderBy, window.ascending}};
+    return TrackOrdering::withSpecLess(columns, spec, [&](auto before) {
+        QList<qsizetype> ordered;
+        if (end == slots.size()) {
+            ordered = slots;
+            std::sort(ordered.begin(), ordered.end(), before);
+        } else {
+            // Куча из end лучших позиций: O(n log k), остальные не копируются
+            ordered.reserve(end);
+            for (qsizetype slot : slots) {
+                if (ordered.size() < end) {
+                    ordered.append(slot);
+                    std::push_heap(ordered.begin(), ordered.end(), before);
+                } else if (end > 0 && before(slot, ordered.first())) {
+                    std::pop_heap(ordered.begin(), ordered.end(), before);
+                    ordered.last() = slot;
+                    std::push_heap(ordered.begin(), ordered.end(), before);
+                }
+            }
+            std::sort_heap(ordered.begin(), ordered.end(), before);
+        }
+        return idsAt(columns, ordered.mid(begin, end - begin));
+    });
 }
 
+QList<int> TrackSearcher::topIds(QList<qsizetype> slots, const QList<SortKey>& spec, qsizetype count) const {
+    const TrackColumns& columns = repository.trackColumns();
+    const qsizetype selected = qBound(qsizetype(0), count, slots.size());
+    TrackOrdering::withSpecLess(columns, spec, [&](auto before) {
+        const auto end = slots.begin() + selected;
+        if (selected < slots.size()) {
+            // Первые selected позиций на своих местах не упорядочены, остальные хуже любой из них
+            std::nth_element(slots.begin(), end, slots.end(), before);
+        }
+        std::sort(slots.begin(), end, before);
+    });
+    slots.resize(selected);
+    return idsAt(columns, slots);
+}
 
+QList<int> TrackSearcher::topIds(const QList<SortKey>& spec, qsizetype count) const {
+    QList<qsizetype> slots(repository.trackColumns().size());
+    std::iota(slots.begin(), slots.end(), qsizetype(0));
+    return topIds(std::move(slots), spec, count);
+}
 
+SearchSession TrackSearcher::startSession() const {
+    return SearchSession(repository, parallelThreshold);
+}
 
+SearchPlan TrackSearcher::explain(const TrackSearchParams& params) const {
+    SearchPlan plan;
+    runFilters(params, &plan);
+    return plan;
+}
+
+QList<Track> TrackSearcher::runFilters(const TrackSearchParams& params, SearchPlan* plan) const {
+    // Порядок проверок и путь доступа выбирает планировщик
+    const QList<qsizetype> slots = planner.execute(params, parallelThreshold, plan);
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<Track> result = materialize(repository.trackColumns(), slots);
+    if (plan) {
+        plan->steps.append({"materialize", QString(), 1.0, slots.size(), result.size(), timer.nsecsElapsed()});
+    }
+    return result;
+}
@@ -1,83 +1,252 @@
 #include "core/TrackSorter.h"
 #include "core/TrackRepository.h"
-#include "core/Track.h"
-
-// Используем дружественные функции для сравнения треков
-extern bool compareTracksByTitle(const Track& a, const Track& b);
-extern bool compareTracksByArtist(const Track& a, const Track& b);
-extern bool compareTracksByYear(const Track& a, const Track& b);
-extern bool compareTracksByDuration(const Track& a, const Track& b);
+#include "core/TrackColumns.h"
+#include "core/TrackOrdering.h"
+#include "core/ParallelFor.h"
+#include <algorithm>
+#include <numeric>
 
 TrackSorter::TrackSorter(TrackRepository& repository)
-    : repository(repository)
+    : repository(repository), parallelThreshold(DEFAULT_PARALLEL_THRESHOLD)
 {
 }
 
-template <typename T, typename Compare>
-static void shellSort(QList<T>& list, Compare comp)
-{
-    const int n = list.size();
+namespace {
+    // Сортировка фрагмента дороже проверки фильтра, но и ее мелкие фрагменты
+    // проигрывают последовательной сортировке
+    constexpr qsizetype SORT_CHUNK_SIZE = 16384;
+
+    // Слияние отсортированных отрезков runs в out через кучу по их первым элементам
+    template <typename Compare>
+    void mergeRuns(QList<QPair<const quint32*, const quint32*>> runs, quint32* out, Compare less)
+    {
+        using Run = QPair<const quint32*, const quint32*>;
+        runs.erase(std::remove_if(runs.begin(), runs.end(), [](const Run& run) {
+            return run.first == run.second;
+        }), runs.end());
+        // Куча с наименьшим первым элементом в вершине
+        auto later = [&less](const Run& a, const Run& b) { return less(*b.first, *a.first); };
+        std::make_heap(runs.begin(), runs.end(), later);
+        while (runs.size() > 1) {
+            std::pop_heap(runs.begin(), runs.end(), later);
+            Run& run = runs.last();
+            *out++ = *run.first++;
+            if (run.first == run.second) {
+                runs.removeLast();
+            } else {
+                std::push_heap(runs.begin(), runs.end(), later);
+            }
+        }
+        if (!runs.isEmpty()) {
+            std::copy(runs.first().first, runs.first().second, out);
+        }
+    }
 
-    for (int gap = n / 2; gap > 0; gap /= 2) {
-        for (int i = gap; i < n; i++) {
+    // Параллельная сортировка перестановки 0..n-1. Фрагменты сортируются
+    // в пуле потоков; затем по регулярной выборке из фрагментов выбираются
+    // разделители, которые режут каждый фрагмент на полосы, и каждая полоса
+    // многопутевым слиянием из всех фрагментов собирается отдельной задачей.
+    // Порядок before полный (равных позиций нет), поэтому результат совпадает
+    // с последовательной сортировкой, а полосы определены однозначно.
+    template <typename Compare>
+    void parallelSort(QList<quint32>& order, Compare before)
+    {
+        const qsizetype count = order.size();
+        const qsizetype chunkCount = ParallelFor::chunkCount(count, SORT_CHUNK_SIZE);
+        if (chunkCount == 1) {
+            std::sort(order.begin(), order.end(), before);
+            return;
+        }
 
-            T temp = list[i];
-            int j = i;
+        const qsizetype chunkSize = (count + chunkCount - 1) / chunkCount;
+        quint32* data = order.data();
+        auto chunkBegin = [data, count, chunkSize](qsizetype chunk) {
+            return data + std::min(count, chunk * chunkSize);
+        };
+        ParallelFor::run(chunkCount, [&](qsizetype chunk) {
+            std::sort(chunkBegin(chunk), chunkBegin(chunk + 1), before);
+        });
+
+        // По chunkCount - 1 равномерных образцов из каждого фрагмента
+        QList<quint32> samples;
+        samples.reserve(chunkCount * (chunkCount - 1));
+        for (qsizetype chunk = 0; chunk < chunkCount; ++chunk) {
+            const qsizetype size = chunkBegin(chunk + 1) - chunkBegin(chunk);
+            for (qsizetype sample = 1; sample < chunkCount; ++sample) {
+                samples.append(chunkBegin(chunk)[sample * size / chunkCount]);
+            }
+        }
+        std::sort(samples.begin(), samples.end(), before);
+
+        // cuts[band * chunkCount + chunk] — начало полосы band во фрагменте chunk
+        const qsizetype bandCount = chunkCount;
+        QList<const quint32*> cuts((bandCount + 1) * chunkCount);
+        for (qsizetype chunk = 0; chunk < chunkCount; ++chunk) {
+            cuts[chunk] = chunkBegin(chunk);
+            cuts[bandCount * chunkCount + chunk] = chunkBegin(chunk + 1);
+            for (qsizetype band = 1; band < bandCount; ++band) {
+                const quint32 splitter = samples.at(band * (chunkCount - 1));
+                cuts[band * chunkCount + chunk] =
+                    std::lower_bound(chunkBegin(chunk), chunkBegin(chunk + 1), splitter, before);
+            }
+        }
+        QList<qsizetype> bandStarts(bandCount + 1, 0);
+        for (qsizetype band = 0; band < bandCount; ++band) {
+            qsizetype size = 0;
+            for (qsizetype chunk = 0; chunk < chunkCount; ++chunk) {
+                size += cuts.at((band + 1) * chunkCount + chunk) - cuts.at(band * chunkCount + chunk);
+            }
+            bandStarts[band + 1] = bandStarts.at(band) + size;
+        }
 
-            while (j >= gap && comp(temp, list[j - gap])) {
-                list[j] = list[j - gap];
-                j -= gap;
+        QList<quint32> merged(count);
+        quint32* output = merged.data();
+        ParallelFor::run(bandCount, [&](qsizetype band) {
+            QList<QPair<const quint32*, const quint32*>> runs;
+            runs.reserve(chunkCount);
+            for (qsizetype chunk = 0; chunk < chunkCount; ++chunk) {
+                runs.append(qMakePair(cuts.at(band * chunkCount + chunk), cuts.at((band + 1) * chunkCount + chunk)));
             }
+            mergeRuns(runs, output + bandStarts.at(band), before);
+        });
+        order.swap(merged);
+    }
 
-            list[j] = temp;
+    // Сортировка перестановки позиций треков (O(n log n)) по строгому полному
+    // порядку TrackOrdering::withSpecLess. Сравниваются позиции по колонкам
+    // репозитория, сами треки не копируются. Начиная с parallelThreshold
+    // позиций сортировка идет параллельно.
+    template <typename Compare>
+    QList<quint32> sortedOrder(qsizetype count, Compare before, qsizetype parallelThreshold)
+    {
+        QList<quint32> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        if (count < parallelThreshold) {
+            std::sort(order.begin(), order.end(), before);
+        } else {
+            parallelSort(order, before);
         }
+        return order;
     }
-}
 
-    void TrackSorter::sortByTitle(bool ascending) {
-        QList<Track> tracks = repository.findAllTracks();
+    // Порядок по целочисленному ключу: поразрядная (LSD) сортировка по байтам
+    // key - min за O(n) на проход, проходов столько, сколько байт занимает
+    // диапазон ключей (для года — один, для длительности — два). Затем каждая
+    // группа равных ключей досортировывается по ключам названий и id.
+    // Результат совпадает с sortedOrder для TrackOrdering::withSpecLess.
+    QList<quint32> radixOrder(const QList<int>& keys, const QList<QByteArray>& titleKeys,
+                              const QList<int>& ids, bool ascending)
+    {
+        const qsizetype count = keys.size();
+        QList<quint32> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        if (count < 2) {
+            return order;
+        }
 
-        auto cmp = [ascending](const Track& a, const Track& b){
-            const bool result = compareTracksByTitle(a, b);
-            return ascending ? result : !result;
+        const auto [minIt, maxIt] = std::minmax_element(keys.cbegin(), keys.cend());
+        const qint64 minKey = *minIt;
+        const quint32 span = static_cast<quint32>(qint64(*maxIt) - minKey);
+        const int* values = keys.constData();
+        auto digitOf = [values, minKey](quint32 slot, int shift) {
+            return (static_cast<quint32>(qint64(values[slot]) - minKey) >> shift) & 0xFFu;
         };
 
-        shellSort(tracks, cmp);
-        repository.setTracks(tracks);
-    }
+        QList<quint32> buffer(count);
+        for (int shift = 0; shift < 32 && (span >> shift) != 0; shift += 8) {
+            // Подсчет, префиксные суммы и устойчивая раскладка по корзинам
+            qsizetype starts[256] = {};
+            for (quint32 slot : order) {
+                ++starts[digitOf(slot, shift)];
+            }
+            qsizetype position = 0;
+            for (qsizetype& start : starts) {
+                const qsizetype size = start;
+                start = position;
+                position += size;
+            }
+            for (quint32 slot : order) {
+                buffer[starts[digitOf(slot, shift)]++] = slot;
+            }
+            order.swap(buffer);
+        }
+        if (!ascending) {
+            // Обратный проход дает убывание ключа; порядок внутри групп
+            // задает досортировка ниже
+            std::reverse(order.begin(), order.end());
+        }
 
-    void TrackSorter::sortByArtist(bool ascending) {
-        QList<Track> tracks = repository.findAllTracks();
+        const QByteArray* titles = titleKeys.constData();
+        const int* trackIds = ids.constData();
+        auto groupBegin = order.begin();
+        while (groupBegin != order.end()) {
+            const int key = values[*groupBegin];
+            const auto groupEnd = std::find_if(groupBegin, order.end(), [values, key](quint32 slot) {
+                return values[slot] != key;
+            });
+            if (groupEnd - groupBegin > 1) {
+                std::sort(groupBegin, groupEnd, [titles, trackIds, ascending](quint32 a, quint32 b) {
+                    if (const int order = titles[a].compare(titles[b]); order != 0) {
+                        return ascending ? order < 0 : order > 0;
+                    }
+                    return trackIds[a] < trackIds[b];
+                });
+            }
+            groupBegin = groupEnd;
+        }
+        return order;
+    }
+}
 
-        auto cmp = [ascending](const Track& a, const Track& b){
-            const bool result = compareTracksByArtist(a, b);
-            return ascending ? result : !result;
-        };
+void TrackSorter::sortByTitle(bool ascending) {
+    sortByKey(TrackOrder::Title, ascending);
+}
 
-        shellSort(tracks, cmp);
-        repository.setTracks(tracks);
-    }
+void TrackSorter::sortByArtist(bool ascending) {
+    sortByKey(TrackOrder::Artist, ascending);
+}
 
-    void TrackSorter::sortByYear(bool ascending) {
-        QList<Track> tracks = repository.findAllTracks();
+void TrackSorter::sortByYear(bool ascending) {
+    sortByKey(TrackOrder::Year, ascending);
+}
 
-        auto cmp = [ascending](const Track& a, const Track& b){
-            const bool result = compareTracksByYear(a, b);
-            return ascending ? result : !result;
-        };
+void TrackSorter::sortByDuration(bool ascending) {
+    sortByKey(TrackOrder::Duration, ascending);
+}
 
-        shellSort(tracks, cmp);
-        repository.setTracks(tracks);
+void TrackSorter::sortBy(const QList<SortKey>& spec) {
+    const QList<SortKey> keys = TrackOrdering::effectiveSpec(spec);
+    if (keys.isEmpty()) {
+        return;
+    }
+    if (keys.size() == 1) {
+        sortByKey(keys.first().field, keys.first().ascending);
+        return;
     }
+    const TrackColumns& columns = repository.trackColumns();
+    repository.applyPermutation(sortedOrder(columns.size(), TrackOrdering::SpecLess(columns, keys),
+                                            parallelThreshold));
+}
 
-    void TrackSorter::sortByDuration(bool ascending) {
-        QList<Track> tracks = repository.findAllTracks();
+void TrackSorter::sortByKey(TrackOrder order, bool ascending) {
+    const TrackColumns& columns = repository.trackColumns();
+    // Числовой первичный ключ сортируется поразрядно, без сравнений
+    if (order == TrackOrder::Year || order == TrackOrder::Duration) {
+        const QList<int>& keys = order == TrackOrder::Year ? columns.years() : columns.durations();
+        repository.applyPermutation(radixOrder(keys, columns.titleKeys(), columns.ids(), ascending));
+        return;
+    }
+    const QList<SortKey> spec{SortKey{order, ascending}};
+    const QList<quint32> permutation = TrackOrdering::withSpecLess(columns, spec, [&](auto before) {
+        return sortedOrder(columns.size(), before, parallelThreshold);
+    });
+    repository.applyPermutation(permutation);
+}
 
-        auto cmp = [ascending](const Track& a, const Track& b){
-            const bool result = compareTracksByDuration(a, b);
-            return ascending ? result : !result;
-        };
+void TrackSorter::setParallelThreshold(qsizetype threshold) {
+    parallelThreshold = threshold;
+}
 
-        shellSort(tracks, cmp);
-        repository.setTracks(tracks);
-    }
+qsizetype TrackSorter::getParallelThreshold() const {
+    return parallelThreshold;
+}
@@ -0,0 +1,110 @@
+// TrigramIndex.cpp
+#include "core/TrigramIndex.h"
+#include <algorithm>
+#include <iterator>
+
+QList<quint64> TrigramIndex::gramsOf(const QString& foldedText) {
+    QList<quint64> grams;
+    const qsizetype count = foldedText.size() - GRAM_SIZE + 1;
+    if (count <= 0) {
+        return grams;
+    }
+    grams.reserve(count);
+    const QChar* text = foldedText.constData();
+    for (qsizetype i = 0; i < count; ++i) {
+        grams.append((static_cast<quint64>(text[i].unicode()) << 32) |
+                     (static_cast<quint64>(text[i + 1].unicode()) << 16) |
+                     static_cast<quint64>(text[i + 2].unicode()));
+    }
+    // Повторяющиеся триграммы учитываем один раз
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void TrigramIndex::insert(int key, const QString& foldedText) {
+    for (quint64 gram : gramsOf(foldedText)) {
+        QList<int>& list = postings[gram];
+        // Новые треки обычно получают наибольший id: добавление в конец за O(1)
+        if (list.isEmpty() || list.last() < key) {
+            list.append(key);
+            continue;
+        }
+        const auto it = std::lower_bound(list.begin(), list.end(), key);
+        if (it == list.end() || *it != key) {
+            list.insert(it, key);
+        }
+    }
+}
+
+void TrigramIndex::remove(int key, const QString& foldedText) {
+    for (quint64 gram : gramsOf(foldedText)) {
+        const auto found = postings.find(gram);
+        if (found == postings.end()) {
+            continue;
+        }
+        QList<int>& list = found.value();
+        const auto it = std::lower_bound(list.begin(), list.end(), key);
+        if (it != list.end() && *it == key) {
+            list.erase(it);
+        }
+        if (list.isEmpty()) {
+            postings.erase(found);
+        }
+    }
+}
+
+void TrigramIndex::clear() {
+    postings.clear();
+}
+
+bool TrigramIndex::estimate(const QString& foldedPattern, qsizetype& count) const {
+    count = 0;
+    if (foldedPattern.size() < GRAM_SIZE) {
+        return false;
+    }
+    bool first = true;
+    for (quint64 gram : gramsOf(foldedPattern)) {
+        const auto it = postings.constFind(gram);
+        if (it == postings.constEnd()) {
+            count = 0;
+            return true;
+        }
+        if (first || it.value().size() < count) {
+            count = it.value().size();
+            first = false;
+        }
+    }
+    return true;
+}
+
+bool TrigramIndex::candidates(const QString& foldedPattern, QList<int>& keys) const {
+    keys.clear();
+    if (foldedPattern.size() < GRAM_SIZE) {
+        return false;
+    }
+
+    QList<const QList<int>*> lists;
+    for (quint64 gram : gramsOf(foldedPattern)) {
+        const auto it = postings.constFind(gram);
+        if (it == postings.constEnd()) {
+            return true; // триграммы нет ни в одном документе
+        }
+        lists.append(&it.value());
+    }
+
+    // Пересекаем начиная с самого короткого списка
+    std::sort(lists.begin(), lists.end(), [](const QList<int>* a, const QList<int>* b) {
+        return a->size() < b->size();
+    });
+    keys = *lists.first();
+    for (qsizetype i = 1; i < lists.size() && !keys.isEmpty(); ++i) {
+        QList<int> narrowed;
+        narrowed.reserve(keys.size());
+        std::set_intersection(keys.cbegin(), keys.cend(),
+                              lists.at(i)->cbegin(), lists.at(i)->cend(),
+                              std::back_inserter(narrowed));
+        keys = narrowed;
+    }
+    return true;
+}
@@ -26,8 +26,7 @@ bool TXTWriter::saveToTXT(const MusicCatalog& catalog, const QString& filename)
            << "duration" << TXTParser::FIELD_SEPARATOR
            << "filepath\n";
 
-    QList<Track> tracks = catalog.findAllTracks();
-    for (const Track& track : tracks) {
+    for (const Track& track : catalog.tracksView()) {
         // Используем перегруженный оператор << для вывода трека
         stream << track << "\n";
     }
@@ -7,8 +7,7 @@ QString ReportGenerator::generateReport(const MusicCatalog& catalog) {
     QString report = "Отчет по музыкальному каталогу\n\n";
     report += "Всего треков: " + QString::number(catalog.getTrackCount()) + "\n\n";
 
-    QList<Track> tracks = catalog.findAllTracks();
-    for (const Track& track : tracks) {
+    for (const Track& track : catalog.tracksView()) {
         report += QString("ID: %1 | %2 - %3 | %4 | %5\n")
         .arg(track.getId())
             .arg(track.getArtist())
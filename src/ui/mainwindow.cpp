@@ -13,9 +13,12 @@
 #include <QSet>
 #include <QDesktopServices>
 #include <QUrl>
+#include <algorithm>
+#include <iterator>
+#include "exceptions/ParseException.h"
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent)
+    : QMainWindow(parent), liveSearch(catalog.startSearchSession())
 {
     setWindowTitle("Музыкальный каталог");
     setMinimumSize(1000, 700);
@@ -105,50 +108,119 @@ void MainWindow::addNewTrack() {
     showMainCatalog();
 }
 
-void MainWindow::searchTracks() {
-    QString title = searchUI.searchTitleEdit->text();
-    QString artist = searchUI.searchArtistEdit->text();
-    QString album = searchUI.searchAlbumEdit->text();
-    QString genre = searchUI.searchGenreEdit->text();
-
-    int minYear = searchUI.searchMinYear->value();
-    int maxYear = searchUI.searchMaxYear->value();
-    int minDuration = searchUI.searchMinDuration->value();
-    int maxDuration = searchUI.searchMaxDuration->value();
+TrackSearchParams MainWindow::currentSearchParams() const {
+    TrackSearchParams params;
+    params.title = searchUI.searchTitleEdit->text();
+    params.artist = searchUI.searchArtistEdit->text();
+    params.album = searchUI.searchAlbumEdit->text();
+    params.genre = searchUI.searchGenreEdit->text();
+    params.minYear = searchUI.searchMinYear->value();
+    params.maxYear = searchUI.searchMaxYear->value();
+    params.minDuration = searchUI.searchMinDuration->value();
+    params.maxDuration = searchUI.searchMaxDuration->value();
+    params.source = static_cast<TrackSource>(searchUI.searchSourceEdit->currentData().toInt());
+    return params;
+}
 
+void MainWindow::searchTracks() {
     // Получаем результаты фильтрации
-    TrackSearchParams params;
-    params.title = title;
-    params.artist = artist;
-    params.album = album;
-    params.genre = genre;
-    params.minYear = minYear;
-    params.maxYear = maxYear;
-    params.minDuration = minDuration;
-    params.maxDuration = maxDuration;
-    
-    QList<Track> results = catalog.searchTracksWithFilters(params);
+    TrackSearchParams params = currentSearchParams();
+    const QList<int> ids = catalog.searchTrackIdsWithFilters(params);
 
     // Подсветка строк в текущей таблице
     updateTrackTable(); // гарантируем, что таблица содержит все треки
 
-    // Сформируем множество id найденных треков
-    QSet<int> resultIds;
-    for (const Track& t : results) {
-        resultIds.insert(t.getId());
+    // Применяем подсветку поиска
+    highlightResults(QSet<int>(ids.cbegin(), ids.cend()));
+
+    if (ids.isEmpty()) {
+        QMessageBox::information(this, "Поиск", "Треки не найдены");
     }
+}
 
-    // Применяем подсветку поиска
-    if (tableHighlighter) {
-        tableHighlighter->applySearchHighlighting(resultIds);
+void MainWindow::searchByQuery() {
+    QList<int> ids;
+    try {
+        ids = catalog.searchTrackIdsByQuery(searchUI.searchQueryEdit->text());
+    } catch (const ParseException& e) {
+        QMessageBox::warning(this, "Поиск", e.getMessage());
+        return;
     }
 
-    if (results.isEmpty()) {
+    updateTrackTable();
+    highlightResults(QSet<int>(ids.cbegin(), ids.cend()));
+    if (ids.isEmpty()) {
         QMessageBox::information(this, "Поиск", "Треки не найдены");
     }
 }
 
+void MainWindow::applyLiveFilter() {
+    const TrackSearchParams params = currentSearchParams();
+
+    // Пустой фильтр (поля очищены, диапазоны на границах) ничего не подсвечивает
+    const bool filterEmpty = params.title.isEmpty() && params.artist.isEmpty() &&
+                             params.album.isEmpty() && params.genre.isEmpty() &&
+                             params.minYear == searchUI.searchMinYear->minimum() &&
+                             params.maxYear == searchUI.searchMaxYear->maximum() &&
+                             params.minDuration == searchUI.searchMinDuration->minimum() &&
+                             params.maxDuration == searchUI.searchMaxDuration->maximum() &&
+                             params.source == TrackSource::Any;
+    QSet<int> resultIds;
+    if (!filterEmpty) {
+        // Сессия уточняет прошлый результат, пока запрос только сужается
+        const QList<int> ids = liveSearch.search(params);
+        resultIds = QSet<int>(ids.cbegin(), ids.cend());
+    }
 
+    highlightResults(resultIds);
+}
+
+void MainWindow::sortByHeader(int column) {
+    static const TrackOrder columnOrders[] = {TrackOrder::Title, TrackOrder::Artist, TrackOrder::Album,
+                                              TrackOrder::Year, TrackOrder::Genre, TrackOrder::Duration};
+    const int columnCount = int(std::size(columnOrders));
+    // Индикатор в заголовке показывает первичный ключ
+    auto showPrimaryKey = [this, columnCount]() {
+        const SortKey& primary = tableSortSpec.first();
+        const int primaryColumn = int(std::find(columnOrders, columnOrders + columnCount, primary.field) - columnOrders);
+        searchUI.trackTable->horizontalHeader()->setSortIndicator(
+            primaryColumn, primary.ascending ? Qt::AscendingOrder : Qt::DescendingOrder);
+    };
+    if (column < 0 || column >= columnCount) {
+        // Столбец действий не сортируется
+        showPrimaryKey();
+        return;
+    }
+    const TrackOrder order = columnOrders[column];
+
+    auto existing = std::find_if(tableSortSpec.begin(), tableSortSpec.end(),
+                                 [order](const SortKey& key) { return key.field == order; });
+    if (QApplication::keyboardModifiers() & Qt::ShiftModifier) {
+        // Shift+щелчок добавляет столбец следующим ключом или меняет его направление
+        if (existing != tableSortSpec.end()) {
+            existing->ascending = !existing->ascending;
+        } else {
+            tableSortSpec.append(SortKey{order, true});
+        }
+    } else {
+        // Обычный щелчок оставляет один ключ; повторный щелчок меняет направление
+        const bool toggle = tableSortSpec.size() == 1 && existing != tableSortSpec.end();
+        tableSortSpec = {SortKey{order, toggle ? !existing->ascending : true}};
+    }
+
+    showPrimaryKey();
+    multiKeyOrderValid = false;
+
+    updateTrackTable();
+    highlightResults(highlightedIds);
+}
+
+void MainWindow::highlightResults(const QSet<int>& ids) {
+    highlightedIds = ids;
+    if (tableHighlighter) {
+        tableHighlighter->applySearchHighlighting(ids);
+    }
+}
 
 void MainWindow::autoSaveCatalog() const {
     QString fileName = "catalog_autosave.txt";
@@ -370,6 +442,8 @@ void MainWindow::deleteTrackById(int trackId) {
 }
 
 void MainWindow::resetSearch() {
+    highlightedIds.clear();
+    searchUI.searchQueryEdit->clear();
     searchUI.searchTitleEdit->clear();
     searchUI.searchArtistEdit->clear();
     searchUI.searchAlbumEdit->clear();
@@ -378,30 +452,56 @@ void MainWindow::resetSearch() {
     searchUI.searchMaxYear->setValue(2100);
     searchUI.searchMinDuration->setValue(1);
     searchUI.searchMaxDuration->setValue(3600);
+    searchUI.searchSourceEdit->setCurrentIndex(0);
     }
 
 
 void MainWindow::updateTrackTable() {
-    QList<Track> tracks = catalog.findAllTracks();
-    populateTrackTable(tracks);
+    populateTrackTable(tableTrackIds());
+    updateSourceFilterCounts();
+}
+
+QList<int> MainWindow::tableTrackIds() {
+    // Порядок по одному столбцу берется из поддерживаемых каталогом
+    // представлений: хранилище не переставляется, а новые треки сразу
+    // оказываются на своем месте
+    if (tableSortSpec.size() == 1) {
+        ResultWindow window;
+        window.orderBy = tableSortSpec.first().field;
+        window.ascending = tableSortSpec.first().ascending;
+        return catalog.trackIdsInOrder(window);
+    }
+    // Порядок по нескольким столбцам считается по перестановке позиций без
+    // сортировки хранилища и пересчитывается, только когда сменились ключи
+    // или изменился каталог
+    if (!multiKeyOrderValid || multiKeyOrderGeneration != catalog.getGeneration()) {
+        multiKeyOrder = catalog.topTrackIds(tableSortSpec, catalog.getTrackCount());
+        multiKeyOrderGeneration = catalog.getGeneration();
+        multiKeyOrderValid = true;
+    }
+    return multiKeyOrder;
 }
 
-void MainWindow::updateTrackTable(const QList<Track>& tracksToDisplay) {
-    populateTrackTable(tracksToDisplay);
+void MainWindow::updateSourceFilterCounts() {
+    // Число треков по источникам берется из битовых индексов каталога
+    searchUI.searchSourceEdit->setItemText(1, QString("Локальные файлы (%1)")
+                                                  .arg(catalog.countTracksBySource(TrackSource::Local)));
+    searchUI.searchSourceEdit->setItemText(2, QString("Яндекс Музыка (%1)")
+                                                  .arg(catalog.countTracksBySource(TrackSource::YandexMusic)));
 }
 
-void MainWindow::populateTrackTable(const QList<Track>& tracks) {
+void MainWindow::populateTrackTable(const QList<int>& trackIds) {
     // Временно отключаем сортировку при заполнении таблицы
     bool sortingWasEnabled = searchUI.trackTable->isSortingEnabled();
     searchUI.trackTable->setSortingEnabled(false);
 
-    searchUI.trackTable->setRowCount(tracks.size());
+    searchUI.trackTable->setRowCount(trackIds.size());
 
     // Цвет фона для треков из Яндекс Музыки (светло-голубой)
     QColor yandexMusicColor(230, 240, 255);
 
-    for (int i = 0; i < tracks.size(); ++i) {
-        const Track& track = tracks[i];
+    for (int i = 0; i < trackIds.size(); ++i) {
+        const Track& track = *catalog.findTrackById(trackIds.at(i));
 
         // Проверяем, является ли трек загруженным из Яндекс Музыки
         bool isFromYandex = track.isFromYandexMusic();
@@ -532,10 +632,13 @@ QWidget* MainWindow::createMainCatalogScreen() {
     searchUI.trackTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     searchUI.trackTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     searchUI.trackTable->setSelectionMode(QAbstractItemView::SingleSelection);
-    searchUI.trackTable->setSortingEnabled(true);
+    // Порядок строк задает каталог, а не таблица: так доступна сортировка по нескольким столбцам
+    searchUI.trackTable->setSortingEnabled(false);
     searchUI.trackTable->horizontalHeader()->setSortIndicatorShown(true);
     searchUI.trackTable->horizontalHeader()->setSectionsClickable(true);
     searchUI.trackTable->horizontalHeader()->setSortIndicator(0, Qt::AscendingOrder);
+    searchUI.trackTable->horizontalHeader()->setToolTip(
+        "Щелчок — сортировка по столбцу, Shift+щелчок — добавить столбец к сортировке");
 
     // Инициализируем подсветитель таблицы после создания таблицы
     tableHighlighter = new TrackTableHighlighter(searchUI.trackTable, &catalog);
@@ -561,10 +664,19 @@ QWidget* MainWindow::createMainCatalogScreen() {
     filtersTitle->setStyleSheet("font-size: 16px; font-weight: bold;");
 
     auto *filterForm = new QFormLayout;
+    searchUI.searchQueryEdit = new QLineEdit;
+    searchUI.searchQueryEdit->setPlaceholderText("artist:metallica year:1986..1991 dur:>300 -genre:live");
+    searchUI.searchQueryEdit->setToolTip("Поля: title, artist, album, genre, year, dur, source.\n"
+                                         "Условия через пробел — И, OR — ИЛИ, минус — НЕ, скобки группируют.\n"
+                                         "Enter — выполнить запрос");
     searchUI.searchTitleEdit = new QLineEdit;
     searchUI.searchArtistEdit = new QLineEdit;
     searchUI.searchAlbumEdit = new QLineEdit;
     searchUI.searchGenreEdit = new QLineEdit;
+    searchUI.searchSourceEdit = new QComboBox;
+    searchUI.searchSourceEdit->addItem("Любой", static_cast<int>(TrackSource::Any));
+    searchUI.searchSourceEdit->addItem("Локальные файлы", static_cast<int>(TrackSource::Local));
+    searchUI.searchSourceEdit->addItem("Яндекс Музыка", static_cast<int>(TrackSource::YandexMusic));
     searchUI.searchMinYear = new QSpinBox;
     searchUI.searchMinYear->setRange(1900, 2100);
     searchUI.searchMinYear->setSpecialValueText("Любой");
@@ -589,11 +701,14 @@ QWidget* MainWindow::createMainCatalogScreen() {
     searchUI.searchMaxYear->setValue(2100);
     searchUI.searchMinDuration->setValue(1);
     searchUI.searchMaxDuration->setValue(3600);
+    searchUI.searchSourceEdit->setCurrentIndex(0);
 
+    filterForm->addRow("Запрос:", searchUI.searchQueryEdit);
     filterForm->addRow("Название:", searchUI.searchTitleEdit);
     filterForm->addRow("Исполнитель:", searchUI.searchArtistEdit);
     filterForm->addRow("Альбом:", searchUI.searchAlbumEdit);
     filterForm->addRow("Жанр:", searchUI.searchGenreEdit);
+    filterForm->addRow("Источник:", searchUI.searchSourceEdit);
     filterForm->addRow("Год от:", searchUI.searchMinYear);
     filterForm->addRow("Год до:", searchUI.searchMaxYear);
     filterForm->addRow("Длительность от:", searchUI.searchMinDuration);
@@ -621,12 +736,30 @@ QWidget* MainWindow::createMainCatalogScreen() {
     connect(addButton, &QPushButton::clicked, this, &MainWindow::showAddTrack);
     connect(yandexSearchButton, &QPushButton::clicked, this, &MainWindow::searchYandexMusic);
     connect(applyFiltersBtn, &QPushButton::clicked, this, &MainWindow::searchTracks);
+    connect(searchUI.searchQueryEdit, &QLineEdit::returnPressed, this, &MainWindow::searchByQuery);
+
+    // Живой фильтр: запускается после паузы в наборе, а не на каждое нажатие
+    liveFilterTimer = new QTimer(this);
+    liveFilterTimer->setSingleShot(true);
+    liveFilterTimer->setInterval(150);
+    connect(liveFilterTimer, &QTimer::timeout, this, &MainWindow::applyLiveFilter);
+    for (QLineEdit *edit : {searchUI.searchTitleEdit, searchUI.searchArtistEdit,
+                            searchUI.searchAlbumEdit, searchUI.searchGenreEdit}) {
+        connect(edit, &QLineEdit::textChanged, liveFilterTimer, qOverload<>(&QTimer::start));
+    }
+    for (QSpinBox *spinBox : {searchUI.searchMinYear, searchUI.searchMaxYear,
+                              searchUI.searchMinDuration, searchUI.searchMaxDuration}) {
+        connect(spinBox, &QSpinBox::valueChanged, liveFilterTimer, qOverload<>(&QTimer::start));
+    }
+    connect(searchUI.searchSourceEdit, &QComboBox::currentIndexChanged,
+            liveFilterTimer, qOverload<>(&QTimer::start));
     connect(resetFiltersBtn, &QPushButton::clicked, this, [this]() {
         resetSearch();
         updateTrackTable();
     });
     connect(searchUI.trackTable, &QTableWidget::cellDoubleClicked, this, &MainWindow::openTrackFile);
-    // Сортировка по клику по заголовку работает автоматически при setSortingEnabled(true)
+    connect(searchUI.trackTable->horizontalHeader(), &QHeaderView::sectionClicked,
+            this, &MainWindow::sortByHeader);
 
     return catalogWidget;
 }